@@ -0,0 +1,59 @@
+#!/bin/sh
+# usage: check.sh [--io-only] <source.cpp> <compiler output.s>
+# Compares the instruction mnemonics of each function in the compiler output
+# with the `// expect:` comment above its definition in the source.
+# With --io-only (for -O0, where every function sets up a frame) only the
+# instructions which touch I/O registers are compared, leaving out the stack
+# pointer and SREG accesses of the prologue and epilogue, and functions marked
+# `// expect when optimized:` are skipped.
+
+io_only=0
+if [ "$1" = "--io-only" ]; then
+    io_only=1
+    shift
+fi
+
+src=$1
+asm=$2
+
+awk '
+    /\/\/ expect( when optimized)?:/ { optimized = /when optimized/; sub(/.*expect[a-z ]*: */, ""); expected = $0; next }
+    expected != "" && match($0, /void [A-Za-z_0-9]+\(/) {
+        print substr($0, RSTART + 5, RLENGTH - 6), optimized, expected
+        expected = ""
+    }' "$src" |
+{
+    status=0
+    while read -r name optimized expected; do
+        if [ $io_only = 1 ] && [ $optimized = 1 ]; then
+            echo "skip $name: optimized builds only"
+            continue
+        fi
+
+        actual=$(awk -v f="$name" -v io_only=$io_only '
+            $0 == f ":" { on = 1; next }
+            on && /^[ \t]*\.size/ { exit }
+            on {
+                sub(/^[ \t]+/, "")
+                # directives, comments, inline asm line markers and labels
+                if ($0 == "" || $0 ~ /^[.\/;#]/ || $0 ~ /:$/) next
+                if (io_only && ($1 !~ /^(sbi|cbi|sbic|sbis|in|out|lds|sts)$/ || $0 ~ /__SP_[HL]__|__SREG__/)) next
+                printf "%s%s", sep, $1
+                sep = " "
+            }' "$asm")
+        if [ $io_only = 1 ]; then
+            expected=$(echo "$expected" | awk '{
+                for (i = 1; i <= NF; i++)
+                    if ($i ~ /^(sbi|cbi|sbic|sbis|in|out|lds|sts)$/) { printf "%s%s", sep, $i; sep = " " }
+            }')
+        fi
+
+        if [ "$actual" = "$expected" ]; then
+            echo "ok   $name: $actual"
+        else
+            echo "FAIL $name: expected '$expected', got '${actual:-nothing}'"
+            status=1
+        fi
+    done
+    exit $status
+}
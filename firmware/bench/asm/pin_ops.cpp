@@ -0,0 +1,39 @@
+// Hot-path pin operations for `make asm-check`, which compiles this file and
+// compares the instructions of each function with the `expect:` line above it.
+
+#include "port.hpp"
+
+using namespace gb7;
+
+namespace
+{
+    using pin_b = pin_writable<port_type::PortB, 1>;
+    using pin_c = pin_writable<port_type::PortC, 5>;
+    using pin_d = pin_writable<port_type::PortD, 6>;
+}
+
+// expect: sbi ret
+extern "C" void pin_b_set_high() { pin_b {}.set_high(); }
+// expect: cbi ret
+extern "C" void pin_b_set_low() { pin_b {}.set_low(); }
+// expect: sbi ret
+extern "C" void pin_b_toggle() { pin_b {}.toggle(); }
+
+// expect: sbi ret
+extern "C" void pin_c_set_high() { pin_c {}.set_high(); }
+// expect: cbi ret
+extern "C" void pin_c_set_low() { pin_c {}.set_low(); }
+// expect: sbi ret
+extern "C" void pin_c_toggle() { pin_c {}.toggle(); }
+
+// expect: sbi ret
+extern "C" void pin_d_set_high() { pin_d {}.set_high(); }
+// expect: cbi ret
+extern "C" void pin_d_set_low() { pin_d {}.set_low(); }
+// expect: sbi ret
+extern "C" void pin_d_toggle() { pin_d {}.toggle(); }
+// write() branches on its argument, which is only a constant once inlined
+// expect when optimized: sbi ret
+extern "C" void pin_d_write_true() { pin_d {}.write(true); }
+// expect when optimized: cbi ret
+extern "C" void pin_d_assign_false() { pin_d {} = false; }
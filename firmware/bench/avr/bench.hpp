@@ -0,0 +1,99 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+// Helpers for the cycle-count benchmark images run under simavr (make bench).
+// Timer1 runs undivided as a cycle counter and results go to the simavr
+// console through GPIOR0.
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/avr_mcu_section.h>
+
+#define GB7_TIMER_USE_INVOKE
+#include "timer.hpp"
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+namespace gb7::bench
+{
+    inline void put(char c) noexcept
+    {
+        GPIOR0 = c;
+    }
+
+    inline void print(const char* s) noexcept
+    {
+        while (*s) put(*s++);
+    }
+
+    inline void print(uint32_t v) noexcept
+    {
+        char buf[11];
+        uint8_t i = 0;
+        do
+        {
+            buf[i++] = '0' + v % 10;
+            v /= 10;
+        } while (v != 0);
+
+        while (i > 0) put(buf[--i]);
+    }
+
+    class cycle_counter
+    {
+        static inline uint16_t overhead = 0;
+
+    public:
+        cycle_counter() = delete;
+
+        static void init() noexcept
+        {
+            cli();
+            timer::raw_timers::raw_timer1::init(
+                timer::raw_timers::pwm_mode::none, timer::raw_timers::pwm_mode::none,
+                timer::raw_timers::timer1_mode::normal, timer::raw_timers::clock_division::no_division
+            );
+            overhead = 0;
+            overhead = measure([] {});
+        }
+
+        // Cycles spent in f(), excluding the cost of reading the counter.
+        // Interrupts must stay disabled, and f() must take less than 65536 cycles.
+        template<class Func>
+        static uint16_t measure(Func f) noexcept
+        {
+            timer::raw_timers::raw_timer1::set_count(0);
+            asm volatile("" ::: "memory");
+            f();
+            asm volatile("" ::: "memory");
+            return timer::raw_timers::raw_timer1::get_count() - overhead;
+        }
+    };
+
+    inline void report(const char* name, uint16_t cycles) noexcept
+    {
+        print(name);
+        print(": ");
+        print(cycles);
+        print(" cycles\n");
+    }
+
+    template<class Func>
+    inline void run(const char* name, Func f) noexcept
+    {
+        report(name, cycle_counter::measure(f));
+    }
+
+    // simavr exits when the core sleeps with interrupts disabled
+    [[noreturn]] inline void finish() noexcept
+    {
+        cli();
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_enable();
+        while (true) sleep_cpu();
+    }
+} // namespace gb7::bench
+
+#endif // BENCH_HPP
@@ -0,0 +1,73 @@
+// Cycle counts of the containers behind the timer and speaker queues.
+
+#include "bench.hpp"
+#include "vector.hpp"
+#include "queue.hpp"
+#include "priority_queue.hpp"
+#include "ring_buffer.hpp"
+#include "pool_allocator.hpp"
+
+using namespace gb7;
+
+namespace
+{
+    // same shape as multitimer's heap item
+    struct item
+    {
+        uint32_t time;
+        uint32_t period;
+        void* func;
+        void* data;
+
+        bool operator>(const item& lhs) const noexcept { return time > lhs.time; }
+        bool operator<(const item& lhs) const noexcept { return time < lhs.time; }
+    };
+
+    priority_queue<item, 16> heap;
+    priority_queue<item, 16>::handle handles[16];
+    queue<item, 16> fifo;
+    ring_buffer<item, 16> ring;
+    item block[8];
+    vector<item, 16> stack;
+
+    // worst case for push: every new item is the new minimum
+    void fill_heap(uint8_t count)
+    {
+        for (uint8_t i = 0; i < count; i++)
+            handles[i] = heap.push({ 1000u - i, 0, nullptr, nullptr });
+    }
+    void clear_heap()
+    {
+        while (heap.pop()) {}
+    }
+}
+
+int main()
+{
+    bench::cycle_counter::init();
+
+    fill_heap(15);
+    bench::run("priority_queue<16> push (15 -> 16, to root)", [] { handles[15] = heap.push({ 0, 0, nullptr, nullptr }); });
+    bench::run("priority_queue<16> pop (16 -> 15)", [] { heap.pop(); });
+    bench::run("priority_queue<16> update_top (to leaf)", [] { heap.update_top({ 5000, 0, nullptr, nullptr }); });
+    bench::run("priority_queue<16> erase (middle)", [] { heap.erase(handles[7]); });
+    bench::run("priority_queue<16> erase (stale)", [] { heap.erase(handles[7]); });
+    clear_heap();
+
+    bench::run("queue<16> push", [] { fifo.push({ 1, 2, nullptr, nullptr }); });
+    bench::run("queue<16> pop", [] { item temp; fifo.pop(temp); });
+
+    bench::run("ring_buffer<16> push", [] { ring.push({ 1, 2, nullptr, nullptr }); });
+    bench::run("ring_buffer<16> pop", [] { item temp; ring.pop(temp); });
+    bench::run("ring_buffer<16> push 8", [] { ring.push(block); });
+    bench::run("ring_buffer<16> pop 8", [] { ring.pop(block); });
+
+    bench::run("vector<16> push", [] { stack.push({ 1, 2, nullptr, nullptr }); });
+    bench::run("vector<16> pop", [] { item temp; stack.pop(temp); });
+
+    static void* block;
+    bench::run("pool_allocator allocate(12)", [] { block = pool_allocator::allocate(12); });
+    bench::run("pool_allocator deallocate", [] { pool_allocator::deallocate(block); });
+
+    bench::finish();
+}
@@ -0,0 +1,69 @@
+// Cycle counts of the port and pin writes, the input scanner and the LED matrix scan.
+
+#include "bench.hpp"
+#include "port.hpp"
+#include "input.hpp"
+#include "led_matrix.hpp"
+
+using namespace gb7;
+
+namespace
+{
+    // a 4-bit LCD data bus split over two ports
+    using d4 = pin_writable<port_type::PortD, 4>;
+    using d5 = pin_writable<port_type::PortD, 5>;
+    using d6 = pin_writable<port_type::PortB, 0>;
+    using d7 = pin_writable<port_type::PortB, 1>;
+
+    void write_pins(uint8_t v)
+    {
+        d4 {}.write(v & 0b0001);
+        d5 {}.write(v & 0b0010);
+        d6 {}.write(v & 0b0100);
+        d7 {}.write(v & 0b1000);
+    }
+}
+
+int main()
+{
+    bench::cycle_counter::init();
+
+    port_writable<port_type::PortD> port;
+    auto pin = port.get_writable_pin<3>();
+
+    bench::run("pin_writable set_high", [&] { pin.set_high(); });
+    bench::run("pin_writable set_low", [&] { pin.set_low(); });
+    bench::run("pin_writable write(true)", [&] { pin.write(true); });
+    bench::run("pin_writable pin = !pin", [&] { pin = !pin; });
+    bench::run("pin_writable toggle", [&] { pin.toggle(); });
+    bench::run("port_writable write", [&] { port.write(0x5a); });
+
+    pin_group<d4, d5, d6, d7> bus;
+    pin_group<pin_writable<port_type::PortB, 3>, pin_writable<port_type::PortD, 0>,
+              pin_writable<port_type::PortC, 2>, pin_writable<port_type::PortB, 5>> scrambled;
+    volatile uint8_t value = 0b1010;
+    bench::run("4 pin_writable writes", [&] { write_pins(value); });
+    bench::run("pin_group write, 2 ports", [&] { bus.write(value); });
+    bench::run("pin_group write, 3 ports unordered", [&] { scrambled.write(value); });
+
+
+    using buttons = input_scanner<scanned_port<port_type::PortB, 0x0f>, scanned_port<port_type::PortC>,
+                                  scanned_port<port_type::PortD, 0xf0, false>>;
+    bench::run("input_scanner scan, 3 ports", [] { buttons::scan(); });
+
+    // 8x8, rows on Port B, columns on Port D
+    using rows = pin_group<pin_writable<port_type::PortB, 0>, pin_writable<port_type::PortB, 1>,
+                           pin_writable<port_type::PortB, 2>, pin_writable<port_type::PortB, 3>,
+                           pin_writable<port_type::PortB, 4>, pin_writable<port_type::PortB, 5>,
+                           pin_writable<port_type::PortB, 6>, pin_writable<port_type::PortB, 7>>;
+    using columns = pin_group<pin_writable<port_type::PortD, 0>, pin_writable<port_type::PortD, 1>,
+                              pin_writable<port_type::PortD, 2>, pin_writable<port_type::PortD, 3>,
+                              pin_writable<port_type::PortD, 4>, pin_writable<port_type::PortD, 5>,
+                              pin_writable<port_type::PortD, 6>, pin_writable<port_type::PortD, 7>>;
+    using display = led_matrix<rows, columns>;
+    display::init();
+    display::stop();
+    bench::run("led_matrix scan, 8x8", [] { display::scan(); });
+
+    bench::finish();
+}
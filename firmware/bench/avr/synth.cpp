@@ -0,0 +1,33 @@
+// Cycle counts of the synth mixer, the part of the sample ISR which depends on
+// the channel count. ISR entry and exit are not included.
+
+#define GB7_SYNTH_USE_ISR
+
+#include "bench.hpp"
+#include "synth.hpp"
+
+using namespace gb7;
+using namespace gb7::sound;
+
+int main()
+{
+    bench::cycle_counter::init();
+
+    synth::init();
+    cli();
+    for (uint8_t i = 0; i < synth::channels; i++)
+    {
+        synth::set_waveform(i, static_cast<waveform>(i % 3));
+        synth::set_volume(i, 200);
+        synth::play(i, Tone::A);
+    }
+
+    uint8_t sample = 0;
+    bench::run("synth next_sample", [&] { sample = synth::next_sample(); });
+    bench::run("synth on_overflow skip", [] { synth::on_overflow(); });
+    for (uint8_t i = 1; i < GB7_SYNTH_DIVIDER - 1; i++) synth::on_overflow();
+    bench::run("synth on_overflow sample", [] { synth::on_overflow(); });
+    OCR0B = sample;
+
+    bench::finish();
+}
@@ -0,0 +1,95 @@
+// Cycle counts of the multitimer tick and the speaker callback.
+
+#include "bench.hpp"
+#include "speaker.hpp"
+
+using namespace gb7;
+using namespace gb7::timer;
+
+namespace
+{
+    constexpr uint8_t max_timers = 16;
+
+    void noop(void*) {}
+
+    timer_node nodes[max_timers] = {
+        { noop }, { noop }, { noop }, { noop }, { noop }, { noop }, { noop }, { noop },
+        { noop }, { noop }, { noop }, { noop }, { noop }, { noop }, { noop }, { noop },
+    };
+    timer_handle handles[max_timers];
+
+    // `count` heap timers, the first one firing on the next tick if `due`
+    void schedule_heap(uint8_t count, bool due)
+    {
+        for (uint8_t i = 0; i < count; i++)
+            handles[i] = multitimer::invoke_every(due && i == 0 ? 1 : 1000, due && i == 0 ? 0 : 1000 + i, noop);
+    }
+    void cancel_heap(uint8_t count)
+    {
+        for (uint8_t i = 0; i < count; i++)
+            multitimer::cancel_invocation(handles[i]);
+    }
+
+    void schedule_nodes(uint8_t count, bool due)
+    {
+        for (uint8_t i = 0; i < count; i++)
+            multitimer::schedule_every(nodes[i], due && i == 0 ? 1 : 1000, due && i == 0 ? 0 : 1000 + i);
+    }
+    void cancel_nodes(uint8_t count)
+    {
+        for (uint8_t i = 0; i < count; i++)
+            multitimer::cancel(nodes[i]);
+    }
+
+    void bench_tick(uint8_t count)
+    {
+        bench::print("timers: ");
+        bench::print(count);
+        bench::put('\n');
+
+        schedule_heap(count, false);
+        bench::run("  on_timer_interrupt heap idle", [] { multitimer::on_timer_interrupt(); });
+        cancel_heap(count);
+
+        schedule_heap(count, true);
+        bench::run("  on_timer_interrupt heap due", [] { multitimer::on_timer_interrupt(); });
+        cancel_heap(count);
+
+        schedule_nodes(count, false);
+        bench::run("  on_timer_interrupt node idle", [] { multitimer::on_timer_interrupt(); });
+        cancel_nodes(count);
+
+        schedule_nodes(count, true);
+        bench::run("  on_timer_interrupt node due", [] { multitimer::on_timer_interrupt(); });
+        cancel_nodes(count);
+    }
+
+    using speaker_pin = pin_writable<port_type::PortB, 1>;
+    using speaker_type = sound::speaker<speaker_pin>;
+
+    const sound::packed_note tune[] PROGMEM = {
+        sound::note(sound::Tone::C, 100000),
+        sound::note(sound::Tone::E, 100000),
+    };
+}
+
+int main()
+{
+    bench::cycle_counter::init();
+
+    bench_tick(1);
+    bench_tick(4);
+    bench_tick(16);
+
+    // the constructor starts Timer2 and enables interrupts
+    static speaker_type sp;
+    cli();
+
+    sp.play(sound::make_sequence(tune));
+    bench::run("speaker::on_timer note start", [] { speaker_type::on_timer<speaker_pin>(&sp); });
+    bench::run("speaker::on_timer toggle", [] { speaker_type::on_timer<speaker_pin>(&sp); });
+    sp.stop_note();
+    bench::run("speaker::on_timer idle", [] { speaker_type::on_timer<speaker_pin>(&sp); });
+
+    bench::finish();
+}
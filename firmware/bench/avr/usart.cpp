@@ -0,0 +1,36 @@
+// Cycle counts of the USART driver, and its output through simavr's UART:
+// `make usart-check` expects the line below on the simavr console.
+
+#define GB7_USART_USE_ISR
+
+#include "bench.hpp"
+#include "usart.hpp"
+
+using namespace gb7;
+
+namespace
+{
+    const uint8_t block[16] = { 'u', 's', 'a', 'r', 't', ' ', 'b', 'e', 'n', 'c', 'h', ' ', '1', '6', 'B', '\n' };
+}
+
+int main()
+{
+    bench::cycle_counter::init();
+    usart::init();
+    cli(); // measure() runs with interrupts disabled
+
+    bench::run("usart write 1 byte", [] { usart::write('\n'); });
+    bench::run("usart write 16 bytes", [] { usart::write(block); });
+    bench::run("usart on_data_register_empty", [] { usart::on_data_register_empty(); });
+
+    // the bytes queued above go out first, then the check line
+    sei();
+    usart::print("gb7 usart ok\n");
+    usart::flush();
+
+    bench::print("usart tx dropped: ");
+    bench::print(usart::tx_dropped());
+    bench::put('\n');
+
+    bench::finish();
+}
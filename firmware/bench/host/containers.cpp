@@ -0,0 +1,306 @@
+// Host benchmark for the gb7 containers. The containers have no AVR
+// dependency, so this builds with the host compiler (make bench-host).
+//
+// usage: bench_containers [--worst]
+//   --worst  heap operations use orderings which sift the full tree height
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vector.hpp"
+#include "queue.hpp"
+#include "priority_queue.hpp"
+#include "ring_buffer.hpp"
+
+
+// every heap allocation goes through here, so "alloc" in the report must stay 0
+static unsigned long allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+void* operator new[](size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+
+namespace
+{
+    // same shape as multitimer's heap item
+    struct timer_item
+    {
+        uint32_t time;
+        uint32_t period;
+        void* func;
+        void* data;
+
+        timer_item() = default;
+        timer_item(uint32_t t) : time(t), period(0), func(nullptr), data(nullptr) {}
+
+        bool operator>(const timer_item& lhs) const { return time > lhs.time; }
+        bool operator<(const timer_item& lhs) const { return time < lhs.time; }
+        operator uint32_t() const { return time; }
+    };
+
+    volatile uint32_t sink;
+    bool worst = false;
+    constexpr double target_ns = 20e6; // per benchmark
+
+    uint32_t lcg_state = 12345;
+    uint32_t next_random()
+    {
+        lcg_state = lcg_state * 1664525u + 1013904223u;
+        return lcg_state >> 8;
+    }
+
+    double now_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+    }
+
+    void report(const char* container, const char* op, size_t n, const char* type, double ns, unsigned long ops, unsigned long allocs)
+    {
+        printf("%-15s %-13s %4zu %-11s %9.2f ns/op  alloc=%lu%s\n",
+            container, op, n, type, ns / ops, allocs, allocs ? "  NOT ALLOCATION-FREE" : "");
+    }
+
+    // Runs `round` repeatedly for about target_ns; `round` returns how many
+    // operations it did. Setup work inside a round is not excluded.
+    template<class Round>
+    void run(const char* container, const char* op, size_t n, const char* type, Round round)
+    {
+        const unsigned long allocs = allocations;
+        unsigned long ops = 0;
+        const double start = now_ns();
+        double elapsed;
+        do
+        {
+            for (int i = 0; i < 64; i++)
+                ops += round();
+            elapsed = now_ns() - start;
+        } while (elapsed < target_ns);
+        report(container, op, n, type, elapsed, ops, allocations - allocs);
+    }
+
+    template<class T, size_t N>
+    void bench_vector(const char* type)
+    {
+        static gb7::vector<T, N> v;
+
+        run("vector", "push+pop", N, type, [] {
+            for (size_t i = 0; i < N; i++)
+                v.push(T(static_cast<uint32_t>(i)));
+            T temp;
+            uint32_t sum = 0;
+            while (v.pop(temp))
+                sum += static_cast<uint32_t>(temp);
+            sink = sum;
+            return 2 * N;
+        });
+
+        for (size_t i = 0; i < N; i++)
+            v.push(T(static_cast<uint32_t>(i)));
+        run("vector", "find(last)", N, type, [] {
+            sink = v.find([](const T& x) { return static_cast<uint32_t>(x) == N - 1; });
+            return 1ul;
+        });
+        T temp;
+        while (v.pop(temp)) {}
+    }
+
+    template<class T, size_t N>
+    void bench_queue(const char* type)
+    {
+        static gb7::queue<T, N> q;
+
+        run("queue", "push+pop", N, type, [] {
+            // start from a rotated head so the wrap-around is exercised
+            q.push(T(0u));
+            T temp;
+            q.pop(temp);
+            for (size_t i = 0; i < N; i++)
+                q.push(T(static_cast<uint32_t>(i)));
+            uint32_t sum = 0;
+            while (q.pop(temp))
+                sum += static_cast<uint32_t>(temp);
+            sink = sum;
+            return 2 * N + 2;
+        });
+
+        for (size_t i = 0; i < N; i++)
+            q.push(T(static_cast<uint32_t>(i)));
+        run("queue", "each_of", N, type, [] {
+            uint32_t sum = 0;
+            q.each_of([&sum](const T& x, size_t) { sum += static_cast<uint32_t>(x); });
+            sink = sum;
+            return N;
+        });
+        q.clear();
+    }
+
+    template<class T, size_t N>
+    void bench_ring_buffer(const char* type)
+    {
+        static gb7::ring_buffer<T, N> r;
+        static T block[N];
+
+        run("ring_buffer", "push+pop", N, type, [] {
+            for (size_t i = 0; i < N; i++)
+                r.push(T(static_cast<uint32_t>(i)));
+            T temp;
+            uint32_t sum = 0;
+            while (r.pop(temp))
+                sum += static_cast<uint32_t>(temp);
+            sink = sum;
+            return 2 * N;
+        });
+
+        run("ring_buffer", "bulk push+pop", N, type, [] {
+            // offset by one so the copy wraps around the end of the storage
+            r.push(T(0u));
+            T temp;
+            r.pop(temp);
+            r.push(block, N);
+            sink = r.pop(block, N);
+            return 2 * N + 2;
+        });
+    }
+
+    template<class T, size_t N, uint32_t KeyMask>
+    void bench_priority_queue(const char* type)
+    {
+        using heap = gb7::priority_queue<T, N>;
+        static heap q;
+        static typename heap::handle handles[N];
+
+        // worst case: every push becomes the new minimum and bubbles to the root
+        static auto key = [](size_t i) -> uint32_t {
+            return worst ? static_cast<uint32_t>((N - 1 - i) & KeyMask) : (next_random() & KeyMask);
+        };
+        static auto fill = [] {
+            for (size_t i = 0; i < N; i++)
+                handles[i] = q.push(T(key(i)));
+        };
+
+        run("priority_queue", "push+pop", N, type, [] {
+            fill();
+            uint32_t sum = 0;
+            while (!q.empty())
+            {
+                sum += static_cast<uint32_t>(q.top());
+                q.pop();
+            }
+            sink = sum;
+            return 2 * N;
+        });
+
+        fill();
+        run("priority_queue", "update_top", N, type, [] {
+            // worst case: the new key is larger than everything and sinks to a leaf
+            for (size_t i = 0; i < N; i++)
+                q.update_top(T(worst ? KeyMask : (next_random() & KeyMask)));
+            return N;
+        });
+        while (q.pop()) {}
+
+        run("priority_queue", "push+erase", N, type, [] {
+            fill();
+            // worst case: always erase the root, so the last leaf sifts all the way down
+            for (size_t i = 0; i < N; i++)
+            {
+                const size_t j = worst ? N - 1 - i : (i * 7) % N;
+                q.erase(handles[j]);
+            }
+            while (q.pop()) {}
+            return 2 * N;
+        });
+
+        run("priority_queue", "erase(stale)", N, type, [] {
+            size_t ops = 0;
+            for (size_t i = 0; i < N; i++, ops++)
+                sink = q.erase(handles[i]);
+            return ops;
+        });
+    }
+
+    template<class T>
+    void bench_all(const char* type)
+    {
+        bench_vector<T, 8>(type);
+        bench_vector<T, 16>(type);
+        bench_vector<T, 64>(type);
+        bench_vector<T, 255>(type);
+
+        bench_queue<T, 8>(type);
+        bench_queue<T, 16>(type);
+        bench_queue<T, 64>(type);
+        bench_queue<T, 255>(type);
+
+        bench_ring_buffer<T, 8>(type);
+        bench_ring_buffer<T, 16>(type);
+        bench_ring_buffer<T, 64>(type);
+        bench_ring_buffer<T, 128>(type);
+    }
+
+    template<class T, uint32_t KeyMask>
+    void bench_heaps(const char* type)
+    {
+        bench_priority_queue<T, 8, KeyMask>(type);
+        bench_priority_queue<T, 16, KeyMask>(type);
+        bench_priority_queue<T, 64, KeyMask>(type);
+        bench_priority_queue<T, 255, KeyMask>(type);
+    }
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--worst") == 0)
+        {
+            worst = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--worst]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("# gb7 container benchmark (%s ordering)\n", worst ? "worst-case" : "random");
+
+    bench_all<uint8_t>("uint8_t");
+    bench_all<uint32_t>("uint32_t");
+    bench_all<timer_item>("timer_item");
+
+    bench_heaps<uint8_t, 0xff>("uint8_t");
+    bench_heaps<uint32_t, 0xffffff>("uint32_t");
+    bench_heaps<timer_item, 0xffffff>("timer_item");
+
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// Renders speaker output on the host. The real speaker and multitimer code
+// runs against a simulated timer; the speaker pin's transitions are written
+// to a WAV file, and the pitch error and timing drift of every note are
+// printed next to the ideal values of the song text. Note boundaries are the
+// simulated times at which the speaker moved on to the next note.
+//
+//   make render SONG=tulip WAV=tulip.wav [MODE=tick|tickless|timer1]
+//   build/host/render_tick <hit|tulip|song.txt> <out.wav>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "sound_effect.hpp"
+
+using namespace gb7;
+using namespace gb7::sound;
+
+namespace
+{
+    unsigned current_line = 0;
+}
+
+// Called by the song parser on bad input; at compile time it is never defined.
+void gb7::sound::song_parser::syntax_error_in_song_text() noexcept
+{
+    fprintf(stderr, "song line %u: syntax error\n", current_line);
+    exit(1);
+}
+
+namespace
+{
+    using speaker_pin = pin_writable<port_type::PortB, 1>;
+
+    constexpr uint32_t wav_rate = 48000;
+    constexpr int16_t wav_level = 12000;
+
+    struct song_note
+    {
+        Tone tone;
+        uint32_t length; // microseconds
+        packed_note packed;
+    };
+
+    /*
+     * timer simulation, one timer count per step
+     */
+    namespace sim
+    {
+        double now_us = 0;
+        uint32_t isr_count = 0;
+
+#if defined GB7_TIMER_USE_TIMER1
+        constexpr const char* mode = "timer1";
+        constexpr double us_per_count = 8e6 / F_CPU;
+
+        void step() noexcept
+        {
+            now_us += us_per_count;
+            TCNT1 = TCNT1 + 1;
+            if ((TIMSK1 & 0b010) && TCNT1 == OCR1A)
+            {
+                isr_count++;
+                TIMER1_COMPA_vect();
+            }
+        }
+#elif defined GB7_TIMER_TICKLESS
+        constexpr const char* mode = "tickless";
+        constexpr double us_per_count = 1024e6 / F_CPU;
+
+        void step() noexcept
+        {
+            now_us += us_per_count;
+            TCNT2 = TCNT2 + 1;
+            if ((TIMSK2 & 0b010) && TCNT2 == OCR2A)
+            {
+                isr_count++;
+                TIMER2_COMPA_vect();
+            }
+        }
+#else
+        constexpr const char* mode = "tick";
+        constexpr double us_per_count = 8e6 / F_CPU;
+
+        void step() noexcept
+        {
+            now_us += us_per_count;
+            TCNT2 = TCNT2 + 1;
+            if ((TIMSK2 & 0b001) && TCNT2 == 0)
+            {
+                isr_count++;
+                TIMER2_OVF_vect();
+            }
+        }
+#endif // GB7_TIMER_USE_TIMER1
+    } // namespace sim
+
+    bool read_text(const char* name, std::string& text)
+    {
+        if (strcmp(name, "hit") == 0)
+        {
+            text = sound_effects::hit_text;
+            return true;
+        }
+        if (strcmp(name, "tulip") == 0)
+        {
+            text = sound_effects::tulip_text;
+            return true;
+        }
+
+        FILE* f = fopen(name, "r");
+        if (f == nullptr) return false;
+
+        char buf[256];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+        fclose(f);
+        return true;
+    }
+
+    // the same steps as the _song literal, run at run time
+    std::vector<song_note> parse(const std::string& text)
+    {
+        std::vector<song_note> notes;
+        size_t begin = 0;
+        while (begin <= text.size())
+        {
+            size_t end = text.find('\n', begin);
+            if (end == std::string::npos) end = text.size();
+
+            current_line++;
+            const song_parser::line l = song_parser::parse_line(text.data() + begin, text.data() + end);
+            if (!l.empty) notes.push_back({ l.tone, l.length, note(l.tone, l.length) });
+
+            begin = end + 1;
+        }
+        return notes;
+    }
+
+    bool write_wav(const char* path, const std::vector<double>& edges, double length_us)
+    {
+        FILE* f = fopen(path, "wb");
+        if (f == nullptr) return false;
+
+        const uint32_t samples = static_cast<uint32_t>(length_us * wav_rate / 1e6);
+        const uint32_t data_size = samples * 2;
+        auto put16 = [f](uint16_t v) { fputc(v & 0xff, f); fputc(v >> 8, f); };
+        auto put32 = [f](uint32_t v) { for (int i = 0; i < 4; i++) fputc((v >> (8 * i)) & 0xff, f); };
+
+        fwrite("RIFF", 1, 4, f);
+        put32(36 + data_size);
+        fwrite("WAVEfmt ", 1, 8, f);
+        put32(16);
+        put16(1); // PCM
+        put16(1); // mono
+        put32(wav_rate);
+        put32(wav_rate * 2);
+        put16(2);
+        put16(16);
+        fwrite("data", 1, 4, f);
+        put32(data_size);
+
+        // the pin starts low and flips at every edge
+        size_t next = 0;
+        bool level = false;
+        for (uint32_t i = 0; i < samples; i++)
+        {
+            const double t = i * 1e6 / wav_rate;
+            while (next < edges.size() && edges[next] <= t)
+            {
+                level = !level;
+                next++;
+            }
+            put16(static_cast<uint16_t>(level ? wav_level : -wav_level));
+        }
+
+        fclose(f);
+        return true;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <hit|tulip|song.txt> <out.wav>\n", argv[0]);
+        return 2;
+    }
+
+    std::string text;
+    if (!read_text(argv[1], text))
+    {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    const std::vector<song_note> notes = parse(text);
+    if (notes.empty())
+    {
+        fprintf(stderr, "%s has no notes\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<packed_note> table;
+    for (const song_note& n : notes) table.push_back(n.packed);
+
+    static speaker<speaker_pin> sp;
+    sp.play({ table.data(), static_cast<uint16_t>(table.size()) });
+
+    // run until the sequence ends, recording pin edges and note boundaries
+    std::vector<double> edges;
+    std::vector<double> boundaries; // start of every note
+    uint16_t left = sp.notes_left();
+    bool level = false;
+    const uint32_t isr_before = sim::isr_count;
+    double song_us = 0;
+    for (const song_note& n : notes) song_us += n.length;
+    const double limit_us = sim::now_us + 2 * song_us + 1e6;
+    while (sp.playing() && sim::now_us < limit_us)
+    {
+        sim::step();
+        if (sp.notes_left() != left)
+        {
+            boundaries.push_back(sim::now_us);
+            left = sp.notes_left();
+        }
+
+        const bool pin = speaker_pin {}.read();
+        if (pin != level)
+        {
+            edges.push_back(sim::now_us);
+            level = pin;
+        }
+    }
+    const double end_us = sim::now_us;
+    if (boundaries.size() != notes.size())
+    {
+        fprintf(stderr, "%zu of %zu notes started before the time limit\n", boundaries.size(), notes.size());
+        return 1;
+    }
+    const double start_us = boundaries.front();
+
+    const double tick_us = timer::tick_cycles * 1e6 / F_CPU;
+    printf("mode %s, tick %.0f us, %zu notes, %u timer interrupts\n",
+        sim::mode, tick_us, notes.size(), sim::isr_count - isr_before);
+    printf("%4s %-5s %10s %10s %9s %11s %11s %9s\n", "#", "tone", "ideal Hz", "actual Hz", "cents", "ideal end", "actual end", "drift");
+
+    // pitch is measured from the edges between two boundaries
+    double ideal_end = 0;
+    double actual_end = 0;
+    double worst_cents = 0;
+    double sum_sq_cents = 0;
+    unsigned pitched = 0;
+    size_t edge = 0;
+    for (size_t i = 0; i < notes.size(); i++)
+    {
+        const song_note& n = notes[i];
+        const double note_start = boundaries[i];
+        const double note_end = i + 1 < boundaries.size() ? boundaries[i + 1] : end_us;
+        actual_end = note_end - start_us;
+        ideal_end += n.length;
+
+        std::vector<double> in_note;
+        while (edge < edges.size() && edges[edge] < note_end - tick_us / 2)
+        {
+            if (edges[edge] >= note_start - tick_us / 2) in_note.push_back(edges[edge]);
+            edge++;
+        }
+
+        char name[5] = "None";
+        for (const auto& t : song_parser::tone_names)
+        {
+            if (t.tone == n.tone && n.tone != Tone::None)
+            {
+                strcpy(name, t.name);
+                name[0] = name[0] - 'a' + 'A';
+            }
+        }
+
+        if (n.tone == Tone::None)
+        {
+            printf("%4zu %-5s %10s %10s %9s %9.1fms %9.1fms %7.2fms\n",
+                i, name, "-", "-", "-", ideal_end / 1e3, actual_end / 1e3, (actual_end - ideal_end) / 1e3);
+            continue;
+        }
+
+        const double ideal_hz = 1e6 / static_cast<uint32_t>(n.tone);
+        if (in_note.size() < 3)
+        {
+            printf("%4zu %-5s %10.2f %10s %9s %9.1fms %9.1fms %7.2fms\n",
+                i, name, ideal_hz, "-", "-", ideal_end / 1e3, actual_end / 1e3, (actual_end - ideal_end) / 1e3);
+            continue;
+        }
+
+        const double actual_hz = 1e6 * (in_note.size() - 1) / (2 * (in_note.back() - in_note.front()));
+        const double cents = 1200 * log2(actual_hz / ideal_hz);
+        if (fabs(cents) > fabs(worst_cents)) worst_cents = cents;
+        sum_sq_cents += cents * cents;
+        pitched++;
+
+        printf("%4zu %-5s %10.2f %10.2f %+9.1f %9.1fms %9.1fms %7.2fms\n",
+            i, name, ideal_hz, actual_hz, cents, ideal_end / 1e3, actual_end / 1e3, (actual_end - ideal_end) / 1e3);
+    }
+
+    printf("pitch error: worst %+.1f cents, rms %.1f cents; drift at end %.2f ms; sequence took %.1f ms\n",
+        worst_cents, pitched > 0 ? sqrt(sum_sq_cents / pitched) : 0.0, (actual_end - ideal_end) / 1e3, (end_us - start_us) / 1e3);
+
+    if (!write_wav(argv[2], edges, end_us + 100e3))
+    {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef GB7_HOST_AVR_EEPROM_H
+#define GB7_HOST_AVR_EEPROM_H
+
+#include <stdint.h>
+
+#define EEMEM
+
+inline void eeprom_busy_wait() noexcept {}
+inline uint32_t eeprom_read_dword(const uint32_t* p) noexcept { return *p; }
+inline void eeprom_write_dword(uint32_t* p, uint32_t v) noexcept { *p = v; }
+
+#endif // GB7_HOST_AVR_EEPROM_H
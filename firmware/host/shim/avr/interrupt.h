@@ -0,0 +1,12 @@
+#ifndef GB7_HOST_AVR_INTERRUPT_H
+#define GB7_HOST_AVR_INTERRUPT_H
+
+// Host stand-in for <avr/interrupt.h>: a vector is an ordinary function which
+// the simulation calls when the interrupt would fire.
+
+#define ISR(vector) extern "C" void vector() noexcept; extern "C" void vector() noexcept
+
+inline void sei() noexcept {}
+inline void cli() noexcept {}
+
+#endif // GB7_HOST_AVR_INTERRUPT_H
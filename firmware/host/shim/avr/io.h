@@ -0,0 +1,68 @@
+#ifndef GB7_HOST_AVR_IO_H
+#define GB7_HOST_AVR_IO_H
+
+// Host stand-in for <avr/io.h>: the ATmega328P registers the library uses,
+// as plain variables which a simulation reads and writes.
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+#define GB7_HOST_REG8(name) inline volatile uint8_t name = 0;
+#define GB7_HOST_REG16(name) inline volatile uint16_t name = 0;
+
+GB7_HOST_REG8(PINB) GB7_HOST_REG8(DDRB) GB7_HOST_REG8(PORTB)
+GB7_HOST_REG8(PINC) GB7_HOST_REG8(DDRC) GB7_HOST_REG8(PORTC)
+GB7_HOST_REG8(PIND) GB7_HOST_REG8(DDRD) GB7_HOST_REG8(PORTD)
+
+GB7_HOST_REG8(TCCR0A) GB7_HOST_REG8(TCCR0B) GB7_HOST_REG8(TCNT0)
+GB7_HOST_REG8(OCR0A) GB7_HOST_REG8(OCR0B) GB7_HOST_REG8(TIMSK0) GB7_HOST_REG8(TIFR0)
+
+GB7_HOST_REG8(TCCR1A) GB7_HOST_REG8(TCCR1B) GB7_HOST_REG8(TCCR1C) GB7_HOST_REG16(TCNT1)
+GB7_HOST_REG16(OCR1A) GB7_HOST_REG16(OCR1B) GB7_HOST_REG16(ICR1) GB7_HOST_REG8(TIMSK1) GB7_HOST_REG8(TIFR1)
+
+GB7_HOST_REG8(TCCR2A) GB7_HOST_REG8(TCCR2B) GB7_HOST_REG8(TCNT2)
+GB7_HOST_REG8(OCR2A) GB7_HOST_REG8(OCR2B) GB7_HOST_REG8(TIMSK2) GB7_HOST_REG8(TIFR2) GB7_HOST_REG8(ASSR)
+
+GB7_HOST_REG8(UCSR0A) GB7_HOST_REG8(UCSR0B) GB7_HOST_REG8(UCSR0C) GB7_HOST_REG16(UBRR0) GB7_HOST_REG8(UDR0)
+
+GB7_HOST_REG8(PCICR) GB7_HOST_REG8(PCIFR) GB7_HOST_REG8(PCMSK0) GB7_HOST_REG8(PCMSK1) GB7_HOST_REG8(PCMSK2)
+
+GB7_HOST_REG8(GPIOR0) GB7_HOST_REG8(SREG) GB7_HOST_REG8(SMCR) GB7_HOST_REG8(MCUCR)
+
+#undef GB7_HOST_REG8
+#undef GB7_HOST_REG16
+
+#define TOV2    0
+#define OCF2A   1
+#define OCF2B   2
+#define TCR2BUB 0
+#define TCR2AUB 1
+#define OCR2BUB 2
+#define OCR2AUB 3
+#define TCN2UB  4
+#define AS2     5
+#define EXCLK   6
+
+#define MPCM0   0
+#define U2X0    1
+#define UPE0    2
+#define DOR0    3
+#define FE0     4
+#define UDRE0   5
+#define TXC0    6
+#define RXC0    7
+#define UCSZ02  2
+#define TXEN0   3
+#define RXEN0   4
+#define UDRIE0  5
+#define TXCIE0  6
+#define RXCIE0  7
+#define UCSZ00  1
+#define UCSZ01  2
+
+#define PCIE0   0
+#define PCIE1   1
+#define PCIE2   2
+
+#endif // GB7_HOST_AVR_IO_H
@@ -0,0 +1,11 @@
+#ifndef GB7_HOST_AVR_PGMSPACE_H
+#define GB7_HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t*>(addr))
+
+#endif // GB7_HOST_AVR_PGMSPACE_H
@@ -0,0 +1,12 @@
+#ifndef GB7_HOST_AVR_SLEEP_H
+#define GB7_HOST_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE     0
+#define SLEEP_MODE_PWR_SAVE 6
+
+inline void set_sleep_mode(int) noexcept {}
+inline void sleep_enable() noexcept {}
+inline void sleep_disable() noexcept {}
+inline void sleep_cpu() noexcept {}
+
+#endif // GB7_HOST_AVR_SLEEP_H
@@ -0,0 +1,11 @@
+#ifndef GB7_HOST_UTIL_ATOMIC_H
+#define GB7_HOST_UTIL_ATOMIC_H
+
+// The simulation is single-threaded and calls vectors only between library
+// calls, so an atomic block is a plain block.
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON      0
+#define ATOMIC_BLOCK(type) for (bool gb7_atomic_once = true; gb7_atomic_once; gb7_atomic_once = false)
+
+#endif // GB7_HOST_UTIL_ATOMIC_H
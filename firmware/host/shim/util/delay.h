@@ -0,0 +1,7 @@
+#ifndef GB7_HOST_UTIL_DELAY_H
+#define GB7_HOST_UTIL_DELAY_H
+
+inline void _delay_ms(double) noexcept {}
+inline void _delay_us(double) noexcept {}
+
+#endif // GB7_HOST_UTIL_DELAY_H
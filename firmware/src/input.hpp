@@ -0,0 +1,223 @@
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#define GB7_TIMER_USE_INVOKE
+
+#include "port.hpp"
+#include "timer.hpp"
+#include "ring_buffer.hpp"
+
+// Time between two samples; a level is accepted after 4 equal samples.
+#ifndef GB7_INPUT_SCAN_MS
+#define GB7_INPUT_SCAN_MS 5
+#endif // GB7_INPUT_SCAN_MS
+
+// Capacity of the event queue; a power of two up to 128.
+#ifndef GB7_INPUT_EVENT_COUNT
+#define GB7_INPUT_EVENT_COUNT 16
+#endif // GB7_INPUT_EVENT_COUNT
+
+
+namespace gb7
+{
+    // The pins of port P in `Mask` scanned by input_scanner. With ActiveLow
+    // (buttons to ground) the pull-ups are enabled and a low level is pressed.
+    template<port_type P, uint8_t Mask = 0xff, bool ActiveLow = true>
+    struct scanned_port
+    {
+        inline static constexpr port_type port = P;
+        inline static constexpr uint8_t mask = Mask;
+        inline static constexpr bool active_low = ActiveLow;
+    };
+
+    struct input_event
+    {
+        port_type port;
+        uint8_t pin;
+        bool pressed;
+    };
+
+    // Debounces whole ports from a multitimer callback. Each port keeps a 2-bit
+    // vertical counter per pin in two bytes, so one sample of 8 pins costs a
+    // fixed handful of byte-wide operations, and a pin's debounced level only
+    // changes after it read the same for 4 samples in a row. Edges are kept as
+    // masks and, one per pin, in an event queue.
+    //   using buttons = input_scanner<scanned_port<port_type::PortC, 0x0f>, scanned_port<port_type::PortD, 0x80>>;
+    //   buttons::init();
+    //   if (buttons::take_pressed<port_type::PortC>() & 0b0001) ...
+    template<class... Ports>
+    class input_scanner
+    {
+        static_assert(sizeof...(Ports) > 0 && sizeof...(Ports) <= 3, "input_scanner takes 1 to 3 ports");
+
+        struct port_state
+        {
+            uint8_t level = 0;   // debounced, 1 = pressed
+            uint8_t ct0 = 0xff;  // vertical counter, low bits
+            uint8_t ct1 = 0xff;  // vertical counter, high bits
+            uint8_t pressed = 0; // edges since the last take_*()
+            uint8_t released = 0;
+        };
+
+        static constexpr port_type port_of[] = { Ports::port... };
+
+        static inline port_state states[sizeof...(Ports)];
+        static inline ring_buffer<input_event, GB7_INPUT_EVENT_COUNT> events; // pushed by the timer ISR
+        static inline uint8_t dropped = 0;
+
+        template<port_type P>
+        static constexpr size_t index_of() noexcept
+        {
+            for (size_t i = 0; i < sizeof...(Ports); i++)
+            {
+                if (port_of[i] == P) return i;
+            }
+            return sizeof...(Ports);
+        }
+
+        template<port_type P>
+        static constexpr void check_port() noexcept
+        {
+            static_assert(index_of<P>() < sizeof...(Ports), "The port is not scanned");
+        }
+
+        static constexpr bool unique() noexcept
+        {
+            for (size_t i = 0; i < sizeof...(Ports); i++)
+            {
+                for (size_t j = i + 1; j < sizeof...(Ports); j++)
+                {
+                    if (port_of[i] == port_of[j]) return false;
+                }
+            }
+            return true;
+        }
+        static_assert(unique(), "A port is listed twice in an input_scanner");
+
+        template<class Port>
+        static void setup() noexcept
+        {
+            *(port_address_converter<Port::port>::get_ddr_address()) &= static_cast<uint8_t>(~Port::mask);
+            if constexpr (Port::active_low)
+            {
+                *(port_address_converter<Port::port>::get_port_address()) |= Port::mask;
+            }
+        }
+
+        template<class Port>
+        static void sample() noexcept
+        {
+            port_state& s = states[index_of<Port::port>()];
+
+            uint8_t raw = *(port_address_converter<Port::port>::get_pin_address());
+            if constexpr (Port::active_low) raw = ~raw;
+
+            // count the pins whose raw level differs from the debounced one;
+            // a counter which wraps around flips the debounced level
+            uint8_t changed = (s.level ^ raw) & Port::mask;
+            s.ct0 = ~(s.ct0 & changed);
+            s.ct1 = s.ct0 ^ (s.ct1 & changed);
+            changed &= s.ct0 & s.ct1;
+            if (changed == 0) return;
+
+            s.level ^= changed;
+            s.pressed |= s.level & changed;
+            s.released |= ~s.level & changed;
+
+            for (uint8_t pin = 0; pin < 8; pin++)
+            {
+                if (!(changed & (1 << pin))) continue;
+                if (!events.push({ Port::port, pin, (s.level & (1 << pin)) != 0 })) dropped++;
+            }
+        }
+
+        static void on_timer(void*)
+        {
+            scan();
+        }
+
+        static inline timer::timer_node node { on_timer };
+
+    public:
+        input_scanner() = delete;
+
+        // Makes the scanned pins inputs and starts sampling every `interval` ticks.
+        static void init(timer::time_unit interval = timer::to_ticks(timer::milliseconds(GB7_INPUT_SCAN_MS))) noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                (setup<Ports>(), ...);
+            }
+
+            timer::multitimer::init();
+            timer::multitimer::schedule_every(node, interval, interval);
+        }
+
+        static void stop() noexcept
+        {
+            timer::multitimer::cancel(node);
+        }
+
+        // Takes one sample of every port. Called from the timer ISR after
+        // init(); call it directly when sampling from another interrupt.
+        static void scan() noexcept
+        {
+            (sample<Ports>(), ...);
+        }
+
+        // debounced levels of port P, 1 = pressed
+        template<port_type P>
+        static uint8_t state() noexcept
+        {
+            check_port<P>();
+            return states[index_of<P>()].level;
+        }
+
+        // Pins of port P pressed since the last call.
+        template<port_type P>
+        static uint8_t take_pressed() noexcept
+        {
+            check_port<P>();
+            uint8_t m;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                m = states[index_of<P>()].pressed;
+                states[index_of<P>()].pressed = 0;
+            }
+            return m;
+        }
+
+        // Pins of port P released since the last call.
+        template<port_type P>
+        static uint8_t take_released() noexcept
+        {
+            check_port<P>();
+            uint8_t m;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                m = states[index_of<P>()].released;
+                states[index_of<P>()].released = 0;
+            }
+            return m;
+        }
+
+        // Pops the oldest edge; false if there is none. Main loop only.
+        static bool poll(input_event& e) noexcept
+        {
+            return events.pop(e);
+        }
+
+        // events lost because the queue was full
+        static uint8_t dropped_events() noexcept
+        {
+            return dropped;
+        }
+    };
+} // namespace gb7
+
+#endif // INPUT_HPP
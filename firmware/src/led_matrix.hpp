@@ -0,0 +1,198 @@
+#ifndef LED_MATRIX_HPP
+#define LED_MATRIX_HPP
+
+#include <stdint.h>
+#include <util/atomic.h>
+
+#define GB7_TIMER_USE_INVOKE
+
+#include "port.hpp"
+#include "timer.hpp"
+
+// Brightness steps per row; 1 turns brightness control off. A row with
+// brightness b is lit in b of every GB7_LED_MATRIX_LEVELS frames.
+#ifndef GB7_LED_MATRIX_LEVELS
+#define GB7_LED_MATRIX_LEVELS 1
+#endif // GB7_LED_MATRIX_LEVELS
+
+// Time each row is shown for by default, rounded to whole multitimer ticks.
+#ifndef GB7_LED_MATRIX_ROW_US
+#define GB7_LED_MATRIX_ROW_US 250
+#endif // GB7_LED_MATRIX_ROW_US
+
+
+namespace gb7
+{
+    // Multiplexed LED matrix with rows and columns on two pin_groups. Each row
+    // time the scan shows the next row: all rows off, the row's column bits
+    // out, the row on, i.e. three pin_group writes of one masked store per
+    // port. The cost per row does not depend on the image. For up to 8 rows
+    // and columns on one port each it is about 60 cycles plus the multitimer
+    // ISR, an unmeasured estimate from counting instructions (run `make bench`
+    // for real numbers). A full frame takes `Rows::size` row times, e.g. 8
+    // rows at the default 250 us take 2 ms, a 500 Hz refresh rate.
+    //
+    // Drawing goes to a back buffer of one bit per LED (bit x of row y);
+    // present() asks the scan to swap it with the front buffer after the last
+    // row, so a frame is never shown half drawn and drawing never stalls the
+    // scan. Draw again once presenting() is false; the new back buffer holds
+    // the frame before the one just presented.
+    //   using rows = pin_group<pin_writable<port_type::PortB, 0>, ...>;
+    //   using cols = pin_group<pin_writable<port_type::PortD, 0>, ...>;
+    //   using display = led_matrix<rows, cols>;
+    //   display::init();
+    //   display::clear(); display::set(3, 4, true); display::present();
+    template<class Rows, class Columns, bool RowActiveLow = false, bool ColumnActiveLow = true>
+    class led_matrix
+    {
+        static_assert(GB7_LED_MATRIX_LEVELS > 0 && GB7_LED_MATRIX_LEVELS < 256, "GB7_LED_MATRIX_LEVELS must fit in 8 bits");
+
+    public:
+        using row_type = typename Columns::value_type;
+        using select_type = typename Rows::value_type;
+        static constexpr uint8_t width = Columns::size;
+        static constexpr uint8_t height = Rows::size;
+        static constexpr uint8_t levels = GB7_LED_MATRIX_LEVELS;
+
+    private:
+        static inline row_type buffers[2][height];
+        static inline volatile uint8_t front = 0; // written by the scan only
+        static inline volatile bool swap = false; // set by present(), cleared by the scan
+        static inline uint8_t row = 0;
+#if GB7_LED_MATRIX_LEVELS > 1
+        static inline uint8_t brightness[height];
+        static inline uint8_t phase = 0;
+#endif // GB7_LED_MATRIX_LEVELS
+
+        static constexpr row_type columns_off = ColumnActiveLow ? static_cast<row_type>(~0) : 0;
+        static constexpr select_type rows_off = RowActiveLow ? static_cast<select_type>(~0) : 0;
+
+        static void on_timer(void*)
+        {
+            scan();
+        }
+
+        static inline timer::timer_node node { on_timer };
+
+    public:
+        led_matrix() = delete;
+
+        // Sets up the pins with everything off and starts the scan, one row
+        // every `row_time`, at full brightness.
+        template<uint32_t N = 1, uint32_t D = 1000000>
+        static void init(timer::duration<N, D> row_time = timer::microseconds(GB7_LED_MATRIX_ROW_US)) noexcept
+        {
+            init(timer::to_ticks(row_time));
+        }
+
+        // As above with the row time in ticks; 0 is taken as 1.
+        static void init(timer::time_unit interval) noexcept
+        {
+            if (interval == 0) interval = 1;
+
+            // constructing the groups makes their pins outputs
+            Rows {};
+            Columns {};
+            Rows::write(rows_off);
+            Columns::write(columns_off);
+#if GB7_LED_MATRIX_LEVELS > 1
+            for (uint8_t i = 0; i < height; i++) brightness[i] = levels;
+#endif // GB7_LED_MATRIX_LEVELS
+
+            timer::multitimer::init();
+            timer::multitimer::schedule_every(node, interval, interval);
+        }
+
+        // Stops the scan with every LED off.
+        static void stop() noexcept
+        {
+            timer::multitimer::cancel(node);
+            Rows::write(rows_off);
+        }
+
+        // Shows the next row. Called from the timer ISR after init().
+        static void scan() noexcept
+        {
+            const row_type bits = buffers[front][row];
+            bool lit = true;
+#if GB7_LED_MATRIX_LEVELS > 1
+            lit = brightness[row] > phase;
+#endif // GB7_LED_MATRIX_LEVELS
+
+            // switch the old row off before changing the columns, or it ghosts
+            Rows::write(rows_off);
+            Columns::write(ColumnActiveLow ? static_cast<row_type>(~bits) : bits);
+            if (lit)
+            {
+                const select_type select = static_cast<select_type>(1) << row;
+                Rows::write(RowActiveLow ? static_cast<select_type>(~select) : select);
+            }
+
+            if (++row < height) return;
+
+            // frame end
+            row = 0;
+#if GB7_LED_MATRIX_LEVELS > 1
+            if (++phase == levels) phase = 0;
+#endif // GB7_LED_MATRIX_LEVELS
+            if (swap)
+            {
+                front = front ^ 1;
+                swap = false;
+            }
+        }
+
+        /*
+         * drawing, main loop only
+         */
+
+        // the buffer drawn to; buffer()[y] bit x is the LED at column x, row y
+        static row_type* buffer() noexcept
+        {
+            return buffers[front ^ 1];
+        }
+
+        static void clear() noexcept
+        {
+            row_type* b = buffer();
+            for (uint8_t y = 0; y < height; y++) b[y] = 0;
+        }
+
+        static void set(uint8_t x, uint8_t y, bool on) noexcept
+        {
+            const row_type bit = static_cast<row_type>(1) << x;
+            if (on) buffer()[y] |= bit;
+            else buffer()[y] &= static_cast<row_type>(~bit);
+        }
+
+        static bool get(uint8_t x, uint8_t y) noexcept
+        {
+            return (buffer()[y] >> x) & 1;
+        }
+
+        // Shows the back buffer from the next frame on.
+        static void present() noexcept
+        {
+            swap = true;
+        }
+
+        // true until the swap asked for by present() has happened
+        static bool presenting() noexcept
+        {
+            return swap;
+        }
+
+        // 0 (off) to `levels` (always lit); a single byte store needs no lock
+        static void set_brightness(uint8_t y, uint8_t level) noexcept
+        {
+#if GB7_LED_MATRIX_LEVELS > 1
+            brightness[y] = level < levels ? level : levels;
+#else
+            (void)y;
+            (void)level;
+#endif // GB7_LED_MATRIX_LEVELS
+        }
+    };
+} // namespace gb7
+
+#endif // LED_MATRIX_HPP
@@ -0,0 +1,175 @@
+#ifndef PCINT_HPP
+#define PCINT_HPP
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#define GB7_TIMER_USE_INVOKE
+
+#include "port.hpp"
+#include "timer.hpp"
+#include "ring_buffer.hpp"
+
+// Capacity of the event queue; a power of two up to 128.
+#ifndef GB7_PCINT_EVENT_COUNT
+#define GB7_PCINT_EVENT_COUNT 16
+#endif // GB7_PCINT_EVENT_COUNT
+
+
+namespace gb7
+{
+    struct pin_change_event
+    {
+        uint32_t time;   // multitimer::timestamp() at the interrupt
+        port_type port;
+        uint8_t changed; // enabled pins which changed
+        uint8_t level;   // enabled pins after the change
+    };
+
+    // Pin change interrupts PCINT0..2 for Port B, C and D. Pins are enabled
+    // as pin_readable types, merged into one PCMSKx mask per port at compile
+    // time. Each interrupt compares the port with its last level and queues
+    // one event for all enabled pins which changed, stamped with the
+    // multitimer clock. Pin changes wake the MCU from every sleep mode, so the
+    // main loop can stay in power::idle() until an input moves.
+    //   using enc_a = pin_readable<port_type::PortD, 2>;
+    //   using enc_b = pin_readable<port_type::PortD, 3>;
+    //   pin_change_interrupt::enable<enc_a, enc_b>();
+    //   pin_change_event e;
+    //   while (pin_change_interrupt::poll(e)) ...
+    //
+    // A pulse shorter than the interrupt latency, or two changes of a pin
+    // before the ISR reads it, may be missed; such signals need a timer
+    // capture instead.
+    class pin_change_interrupt
+    {
+        static inline uint8_t last[3]; // port levels seen by the previous interrupt
+        static inline ring_buffer<pin_change_event, GB7_PCINT_EVENT_COUNT> events; // pushed by the ISRs
+        static inline uint8_t dropped = 0;
+
+        template<port_type P>
+        static constexpr uint8_t index() noexcept
+        {
+            return static_cast<uint8_t>(P);
+        }
+
+        template<port_type P>
+        static volatile uint8_t* mask_register() noexcept
+        {
+            switch (P)
+            {
+            case port_type::PortB:
+                return &PCMSK0;
+            case port_type::PortC:
+                return &PCMSK1;
+            case port_type::PortD:
+                return &PCMSK2;
+            }
+        }
+
+        template<port_type P, class... Pins>
+        static void enable_port() noexcept
+        {
+            constexpr uint8_t mask = port_address_converter<P>::template get_mask<Pins...>();
+            if constexpr (mask != 0)
+            {
+                const uint8_t level = *(port_address_converter<P>::get_pin_address());
+                last[index<P>()] = (last[index<P>()] & static_cast<uint8_t>(~mask)) | (level & mask);
+                *(mask_register<P>()) |= mask;
+                PCIFR = _BV(index<P>()); // drop a change seen before the pins were enabled
+                PCICR |= _BV(index<P>());
+            }
+        }
+
+        template<port_type P, class... Pins>
+        static void disable_port() noexcept
+        {
+            constexpr uint8_t mask = port_address_converter<P>::template get_mask<Pins...>();
+            if constexpr (mask != 0)
+            {
+                volatile uint8_t* reg = mask_register<P>();
+                *reg &= static_cast<uint8_t>(~mask);
+                if (*reg == 0) PCICR &= static_cast<uint8_t>(~_BV(index<P>()));
+            }
+        }
+
+    public:
+        pin_change_interrupt() = delete;
+
+        template<class... Pins>
+        static void enable() noexcept
+        {
+            timer::multitimer::init();
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                enable_port<port_type::PortB, Pins...>();
+                enable_port<port_type::PortC, Pins...>();
+                enable_port<port_type::PortD, Pins...>();
+            }
+        }
+
+        template<class... Pins>
+        static void disable() noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                disable_port<port_type::PortB, Pins...>();
+                disable_port<port_type::PortC, Pins...>();
+                disable_port<port_type::PortD, Pins...>();
+            }
+        }
+
+        // Called from the PCINT ISR of port P.
+        template<port_type P>
+        static void on_interrupt() noexcept
+        {
+            const uint8_t level = *(port_address_converter<P>::get_pin_address());
+            const uint8_t mask = *(mask_register<P>());
+            const uint8_t changed = (level ^ last[index<P>()]) & mask;
+            last[index<P>()] = level;
+            if (changed == 0) return;
+
+            if (!events.push({ timer::multitimer::timestamp(), P, changed, static_cast<uint8_t>(level & mask) })) dropped++;
+        }
+
+        // Pops the oldest event; false if there is none. Main loop only.
+        static bool poll(pin_change_event& e) noexcept
+        {
+            return events.pop(e);
+        }
+
+        // events lost because the queue was full
+        static uint8_t dropped_events() noexcept
+        {
+            return dropped;
+        }
+    };
+} // namespace gb7
+
+
+#ifdef GB7_PCINT_USE_ISR
+
+ISR(PCINT0_vect)
+{
+    gb7::pin_change_interrupt::on_interrupt<gb7::port_type::PortB>();
+}
+
+ISR(PCINT1_vect)
+{
+    gb7::pin_change_interrupt::on_interrupt<gb7::port_type::PortC>();
+}
+
+ISR(PCINT2_vect)
+{
+    gb7::pin_change_interrupt::on_interrupt<gb7::port_type::PortD>();
+}
+
+#else
+
+#warning "GB7_PCINT_USE_ISR must be defined elsewhere."
+
+#endif // GB7_PCINT_USE_ISR
+
+#endif // PCINT_HPP
@@ -0,0 +1,183 @@
+#ifndef POOL_ALLOCATOR_HPP
+#define POOL_ALLOCATOR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <util/atomic.h>
+#include "utils.hpp"
+
+// Blocks per size class. Arenas are static, so their total is reserved at link time.
+#ifndef GB7_POOL_BLOCKS_8
+#define GB7_POOL_BLOCKS_8 8
+#endif // GB7_POOL_BLOCKS_8
+#ifndef GB7_POOL_BLOCKS_16
+#define GB7_POOL_BLOCKS_16 8
+#endif // GB7_POOL_BLOCKS_16
+#ifndef GB7_POOL_BLOCKS_32
+#define GB7_POOL_BLOCKS_32 4
+#endif // GB7_POOL_BLOCKS_32
+#ifndef GB7_POOL_BLOCKS_64
+#define GB7_POOL_BLOCKS_64 2
+#endif // GB7_POOL_BLOCKS_64
+
+
+namespace gb7
+{
+    struct pool_stats
+    {
+        uint16_t block_size;
+        uint16_t capacity;
+        uint16_t used;
+        uint16_t high_water;
+        uint16_t failures;
+    };
+
+    // Fixed-size blocks in a static arena with an intrusive free list:
+    // allocate and deallocate are O(1) and never fragment.
+    template<size_t BlockSize, size_t BlockCount>
+    class fixed_pool
+    {
+        static_assert(BlockCount > 0, "a pool needs at least one block");
+
+        union block
+        {
+            block* next;
+            alignas(max_align_t) uint8_t data[BlockSize];
+        };
+
+        using index = index_type<BlockCount>;
+
+        block arena[BlockCount];
+        block* free_list = nullptr;
+        index unused = BlockCount; // blocks never handed out, taken from the end of the arena
+        index used = 0;
+        index high_water = 0;
+        uint16_t failures = 0;
+
+    public:
+        static constexpr size_t block_size = BlockSize;
+
+        // call with interrupts disabled
+        void* allocate() noexcept
+        {
+            block* b;
+            if (free_list != nullptr)
+            {
+                b = free_list;
+                free_list = b->next;
+            }
+            else if (unused > 0)
+            {
+                b = &arena[--unused];
+            }
+            else
+            {
+                failures++;
+                return nullptr;
+            }
+
+            if (++used > high_water) high_water = used;
+            return b->data;
+        }
+
+        // call with interrupts disabled; `ptr` must come from this pool
+        void deallocate(void* ptr) noexcept
+        {
+            block* b = static_cast<block*>(ptr);
+            b->next = free_list;
+            free_list = b;
+            used--;
+        }
+
+        bool owns(const void* ptr) const noexcept
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(ptr);
+            return p >= arena[0].data && p < arena[0].data + sizeof(arena);
+        }
+
+        pool_stats stats() const noexcept
+        {
+            return { BlockSize, BlockCount, used, high_water, failures };
+        }
+    };
+
+    // Size-class allocator over four fixed pools (8/16/32/64 bytes). A request
+    // goes to the smallest class that fits and fails instead of spilling into
+    // a larger class or the heap, so timing and memory use stay bounded.
+    // Define GB7_USE_POOL_ALLOCATOR to route operator new/delete here (utils.cpp).
+    class pool_allocator
+    {
+        static inline fixed_pool<8, GB7_POOL_BLOCKS_8> pool8;
+        static inline fixed_pool<16, GB7_POOL_BLOCKS_16> pool16;
+        static inline fixed_pool<32, GB7_POOL_BLOCKS_32> pool32;
+        static inline fixed_pool<64, GB7_POOL_BLOCKS_64> pool64;
+        static inline uint16_t oversized = 0;
+
+    public:
+        pool_allocator() = delete;
+
+        static constexpr uint8_t class_count = 4;
+        static constexpr size_t max_size = 64;
+
+        static void* allocate(size_t size) noexcept
+        {
+            void* p = nullptr;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                if (size <= 8) p = pool8.allocate();
+                else if (size <= 16) p = pool16.allocate();
+                else if (size <= 32) p = pool32.allocate();
+                else if (size <= 64) p = pool64.allocate();
+                else oversized++;
+            }
+            return p;
+        }
+
+        // Returns false if `ptr` did not come from allocate().
+        static bool deallocate(void* ptr) noexcept
+        {
+            if (ptr == nullptr) return true;
+
+            bool owned = true;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                if (pool8.owns(ptr)) pool8.deallocate(ptr);
+                else if (pool16.owns(ptr)) pool16.deallocate(ptr);
+                else if (pool32.owns(ptr)) pool32.deallocate(ptr);
+                else if (pool64.owns(ptr)) pool64.deallocate(ptr);
+                else owned = false;
+            }
+            return owned;
+        }
+
+        // per size class, smallest first
+        static pool_stats stats(uint8_t size_class) noexcept
+        {
+            pool_stats s {};
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                switch (size_class)
+                {
+                case 0: s = pool8.stats(); break;
+                case 1: s = pool16.stats(); break;
+                case 2: s = pool32.stats(); break;
+                case 3: s = pool64.stats(); break;
+                }
+            }
+            return s;
+        }
+
+        // requests larger than max_size, which no class can serve
+        static uint16_t oversized_requests() noexcept
+        {
+            uint16_t v;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                v = oversized;
+            }
+            return v;
+        }
+    };
+} // namespace gb7
+
+#endif // POOL_ALLOCATOR_HPP
@@ -1,11 +1,14 @@
 #ifndef PORT_H
 #define PORT_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <avr/io.h>
+#include <util/atomic.h>
 
 namespace gb7
 {
-    enum class port_type
+    enum class port_type: uint8_t
     {
         PortB, PortC, PortD,
     };
@@ -90,28 +93,81 @@ namespace gb7
                 return &PIND;
             }
         }
+
+        // I/O space addresses (memory address - 0x20) for sbi/cbi, as in the
+        // ATmega48/88/168/328 register map: PINx, DDRx, PORTx
+        [[nodiscard]] constexpr static uint8_t get_pin_io_address() noexcept
+        {
+            switch (P)
+            {
+            case port_type::PortB:
+                return 0x03;
+            case port_type::PortC:
+                return 0x06;
+            case port_type::PortD:
+                return 0x09;
+            }
+        }
+        [[nodiscard]] constexpr static uint8_t get_port_io_address() noexcept
+        {
+            return get_pin_io_address() + 2;
+        }
+
+        // bits of this port used by the given pin types
+        template<class... Pins>
+        [[nodiscard]] constexpr static uint8_t get_mask() noexcept
+        {
+            return (0 | ... | (Pins::port == P ? 1 << Pins::number : 0));
+        }
     };
 
 
     template<port_type P, pin_number N>
     class pin_writable
     {
+        static_assert(N <= 7, "Invalid pin number");
+
     private:
         inline static constexpr uint8_t mask = (1 << N);
 
     public:
+        inline static constexpr port_type port = P;
+        inline static constexpr pin_number number = N;
+
         inline bool read() const noexcept
         {
             return (*(port_address_converter<P>::get_port_address()) & mask) != 0;
         }
 
-        inline void set_high() const noexcept
+        // set_high, set_low and toggle are each a single sbi/cbi instruction at
+        // any optimization level, so they are atomic against ISRs which write
+        // other pins of the same port. They are always inlined, so even at -O0
+        // the caller does not pay for a call around the instruction.
+        inline __attribute__((always_inline)) void set_high() const noexcept
         {
+#ifdef __AVR__
+            asm volatile("sbi %0, %1" :: "I" (port_address_converter<P>::get_port_io_address()), "I" (N));
+#else
             *(port_address_converter<P>::get_port_address()) |= mask;
+#endif // __AVR__
         }
-        inline void set_low() const noexcept
+        inline __attribute__((always_inline)) void set_low() const noexcept
         {
+#ifdef __AVR__
+            asm volatile("cbi %0, %1" :: "I" (port_address_converter<P>::get_port_io_address()), "I" (N));
+#else
             *(port_address_converter<P>::get_port_address()) &= ~mask;
+#endif // __AVR__
+        }
+
+        // writing 1 to PINxn flips PORTxn in hardware
+        inline __attribute__((always_inline)) void toggle() const noexcept
+        {
+#ifdef __AVR__
+            asm volatile("sbi %0, %1" :: "I" (port_address_converter<P>::get_pin_io_address()), "I" (N));
+#else
+            *(port_address_converter<P>::get_port_address()) ^= mask;
+#endif // __AVR__
         }
 
         inline void write(bool value) const noexcept
@@ -144,6 +200,9 @@ namespace gb7
         inline static constexpr uint8_t mask = (1 << N);
 
     public:
+        inline static constexpr port_type port = P;
+        inline static constexpr pin_number number = N;
+
         inline bool read() const noexcept
         {
             return (*(port_address_converter<P>::get_pin_address()) & mask) != 0;
@@ -195,6 +254,190 @@ namespace gb7
         }
     };
 
+    namespace pin_group_detail
+    {
+        template<bool Wide>
+        struct value { using type = uint8_t; };
+        template<>
+        struct value<true> { using type = uint16_t; };
+    } // namespace pin_group_detail
+
+    // Several pin_writable pins driven as one bus: bit i of a value goes to the
+    // i-th pin. Pins are merged by port at compile time, and write() updates
+    // each port with a single masked store, with interrupts disabled so that
+    // no ISR sees or clobbers a half-written bus.
+    //   pin_group<pin_writable<port_type::PortD, 4>, pin_writable<port_type::PortD, 5>,
+    //             pin_writable<port_type::PortB, 0>> bus;
+    //   bus = 0b101;
+    template<class... Pins>
+    class pin_group
+    {
+        static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= 16, "A pin_group holds 1 to 16 pins");
+
+    public:
+        using value_type = typename pin_group_detail::value<(sizeof...(Pins) > 8)>::type;
+        inline static constexpr uint8_t size = sizeof...(Pins);
+
+    private:
+        static constexpr port_type port_of[] = { Pins::port... };
+        static constexpr pin_number number_of[] = { Pins::number... };
+
+        template<port_type P>
+        inline static constexpr uint8_t mask = port_address_converter<P>::template get_mask<Pins...>();
+
+        static constexpr bool unique() noexcept
+        {
+            for (size_t i = 0; i < sizeof...(Pins); i++)
+            {
+                for (size_t j = i + 1; j < sizeof...(Pins); j++)
+                {
+                    if (port_of[i] == port_of[j] && number_of[i] == number_of[j]) return false;
+                }
+            }
+            return true;
+        }
+        static_assert(unique(), "A pin is listed twice in a pin_group");
+
+        static constexpr int8_t unaligned = -128;
+
+        // Pin number minus bit index if it is the same for every pin on the
+        // port, so the bits move with one shift; unaligned otherwise.
+        template<port_type P>
+        static constexpr int8_t offset() noexcept
+        {
+            int8_t result = unaligned;
+            for (size_t i = 0; i < sizeof...(Pins); i++)
+            {
+                if (port_of[i] != P) continue;
+
+                const int8_t d = static_cast<int8_t>(number_of[i]) - static_cast<int8_t>(i);
+                if (result != unaligned && result != d) return unaligned;
+                result = d;
+            }
+            return result;
+        }
+
+        // value bits -> port bits
+        template<port_type P>
+        inline static uint8_t to_port(value_type value) noexcept
+        {
+            constexpr int8_t d = offset<P>();
+            if constexpr (d == unaligned)
+            {
+                uint8_t bits = 0;
+                uint8_t i = 0;
+                ((bits |= (Pins::port == P && (value & (static_cast<value_type>(1) << i)) ? 1 << Pins::number : 0), i++), ...);
+                return bits;
+            }
+            else if constexpr (d >= 0)
+            {
+                return static_cast<uint8_t>(value << d) & mask<P>;
+            }
+            else
+            {
+                return static_cast<uint8_t>(value >> -d) & mask<P>;
+            }
+        }
+
+        // port bits -> value bits
+        template<port_type P>
+        inline static value_type from_port(uint8_t bits) noexcept
+        {
+            constexpr int8_t d = offset<P>();
+            if constexpr (d == unaligned)
+            {
+                value_type value = 0;
+                uint8_t i = 0;
+                ((value |= (Pins::port == P && (bits & (1 << Pins::number)) ? static_cast<value_type>(1) << i : 0), i++), ...);
+                return value;
+            }
+            else if constexpr (d >= 0)
+            {
+                return static_cast<value_type>((bits & mask<P>) >> d);
+            }
+            else
+            {
+                return static_cast<value_type>(static_cast<value_type>(bits & mask<P>) << -d);
+            }
+        }
+
+        template<port_type P>
+        inline static void write_port(value_type value) noexcept
+        {
+            if constexpr (mask<P> != 0)
+            {
+                volatile uint8_t* port = port_address_converter<P>::get_port_address();
+                if constexpr (mask<P> == 0xff)
+                {
+                    *port = to_port<P>(value);
+                }
+                else
+                {
+                    *port = (*port & static_cast<uint8_t>(~mask<P>)) | to_port<P>(value);
+                }
+            }
+        }
+
+        template<port_type P>
+        inline static value_type read_port() noexcept
+        {
+            if constexpr (mask<P> != 0)
+            {
+                return from_port<P>(*(port_address_converter<P>::get_port_address()));
+            }
+            else
+            {
+                return 0;
+            }
+        }
+
+        template<port_type P>
+        inline static void make_output() noexcept
+        {
+            if constexpr (mask<P> != 0)
+            {
+                *(port_address_converter<P>::get_ddr_address()) |= mask<P>;
+            }
+        }
+
+    public:
+        pin_group() noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                make_output<port_type::PortB>();
+                make_output<port_type::PortC>();
+                make_output<port_type::PortD>();
+            }
+        }
+
+        // the values last written, read back from PORTx
+        inline static value_type read() noexcept
+        {
+            return read_port<port_type::PortB>() | read_port<port_type::PortC>() | read_port<port_type::PortD>();
+        }
+
+        inline static void write(value_type value) noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                write_port<port_type::PortB>(value);
+                write_port<port_type::PortC>(value);
+                write_port<port_type::PortD>(value);
+            }
+        }
+
+        inline operator value_type() const noexcept
+        {
+            return read();
+        }
+        inline value_type operator=(value_type v) const noexcept
+        {
+            write(v);
+            return v;
+        }
+    };
+
     template<port_type P>
     class port_readable
     {
@@ -0,0 +1,140 @@
+#ifndef POWER_HPP
+#define POWER_HPP
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "timer.hpp"
+
+// Sleep only if the next multitimer callback is at least this many ticks away.
+#ifndef GB7_IDLE_MIN_TICKS
+#define GB7_IDLE_MIN_TICKS 1
+#endif // GB7_IDLE_MIN_TICKS
+
+// Define GB7_IDLE_POWER_SAVE to allow power-save mode. Timer2 keeps running
+// in power-save whether it is clocked from the system clock or from TOSC, so
+// it still wakes the MCU. Power-save is only used if the next callback is at
+// least GB7_IDLE_POWER_SAVE_MIN_TICKS away, to cover the oscillator start-up
+// time on wake-up, and while nothing else needs the I/O clock it stops:
+// Timer0 must be stopped, and USART0 (usart.hpp) must have its receiver off
+// and no byte queued or shifting out. usart::init() turns the receiver on,
+// so with the USART in use the MCU only idles.
+#ifndef GB7_IDLE_POWER_SAVE_MIN_TICKS
+#define GB7_IDLE_POWER_SAVE_MIN_TICKS 16
+#endif // GB7_IDLE_POWER_SAVE_MIN_TICKS
+
+
+namespace gb7
+{
+    // Puts the MCU to sleep between multitimer events. Every interrupt still
+    // wakes it, so in idle mode a callback is never later than it would be
+    // while spinning. Call from the main loop only.
+    class power
+    {
+        static inline uint32_t asleep_ms_total = 0;
+        static inline uint32_t asleep_cycles = 0; // below one millisecond
+        static inline uint32_t sleeps = 0;
+
+        static constexpr uint32_t cycles_per_ms = F_CPU / 1000;
+
+        // The receiver is off and the transmitter has nothing queued (the UDRE
+        // interrupt is off) and has sent the last frame (TXC0, which usart.hpp
+        // clears before every write to UDR0). TXC0 is also clear before the
+        // first frame, so an enabled transmitter which never sent anything
+        // counts as busy.
+        static bool usart_idle() noexcept
+        {
+            const uint8_t control = UCSR0B;
+            if (control & _BV(RXEN0)) return false;
+            if (!(control & _BV(TXEN0))) return true;
+            return !(control & _BV(UDRIE0)) && (UCSR0A & _BV(TXC0));
+        }
+
+        static bool power_save_allowed(timer::time_unit next) noexcept
+        {
+#if defined GB7_IDLE_POWER_SAVE && !defined GB7_TIMER_USE_TIMER1
+            // Timer0 (tone_speaker) and USART0 stop in power-save
+            return next >= GB7_IDLE_POWER_SAVE_MIN_TICKS && (TCCR0B & 0b111) == 0 && usart_idle();
+#else
+            return false;
+#endif // GB7_IDLE_POWER_SAVE
+        }
+
+        static void add_asleep(uint32_t counts) noexcept
+        {
+            asleep_cycles += counts * timer::multitimer::cycles_per_count;
+            if (asleep_cycles >= cycles_per_ms)
+            {
+                asleep_ms_total += asleep_cycles / cycles_per_ms;
+                asleep_cycles %= cycles_per_ms;
+            }
+            sleeps++;
+        }
+
+    public:
+        power() = delete;
+
+        // Sleeps until the next interrupt if no callback is due within
+        // GB7_IDLE_MIN_TICKS and no deferred callback waits for dispatch().
+        // Returns false without sleeping otherwise.
+        static bool idle() noexcept
+        {
+            cli();
+
+            const timer::time_unit next = timer::multitimer::ticks_until_next();
+            if (next < GB7_IDLE_MIN_TICKS)
+            {
+                sei();
+                return false;
+            }
+
+            if (power_save_allowed(next))
+            {
+                // with an asynchronous Timer2, registers written within the last
+                // TOSC cycle must settle, or the MCU may not wake up; the flags
+                // stay clear while Timer2 runs from the system clock
+                while (ASSR & (_BV(TCN2UB) | _BV(OCR2AUB) | _BV(OCR2BUB) | _BV(TCR2AUB) | _BV(TCR2BUB)));
+                set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+            }
+            else
+            {
+                set_sleep_mode(SLEEP_MODE_IDLE);
+            }
+
+            const uint32_t start = timer::multitimer::timestamp();
+            sleep_enable();
+            // the instruction after sei always runs, so a pending interrupt cannot be missed
+            sei();
+            sleep_cpu();
+            sleep_disable();
+
+            cli();
+            const uint32_t counts = timer::multitimer::timestamp() - start;
+            sei();
+
+            add_asleep(counts);
+            return true;
+        }
+
+        // time spent asleep since the last reset_stats()
+        static uint32_t asleep_ms() noexcept
+        {
+            return asleep_ms_total;
+        }
+
+        static uint32_t sleep_count() noexcept
+        {
+            return sleeps;
+        }
+
+        static void reset_stats() noexcept
+        {
+            asleep_ms_total = 0;
+            asleep_cycles = 0;
+            sleeps = 0;
+        }
+    };
+} // namespace gb7
+
+#endif // POWER_HPP
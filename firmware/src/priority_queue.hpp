@@ -2,62 +2,130 @@
 #define PRIORITY_QUEUE_HPP
 
 #include <stddef.h>
-#include "vector.hpp"
+#include <stdint.h>
+#include "utils.hpp"
 
 namespace gb7
 {
+    // Indexed binary heap. Each element lives in a fixed slot and the heap
+    // orders slot indices, so an element can be found from its handle in O(1)
+    // and erased or updated in O(log n).
     template<class T, size_t N = 16>
     class priority_queue
     {
-        struct item
+        static_assert(N > 0 && N < 256, "priority_queue supports 1 to 255 elements");
+
+    public:
+        // slot index in the low byte, slot generation in the high byte; 0 is never valid
+        using handle = uint16_t;
+
+    private:
+        using index = index_type<N>;
+
+        struct slot
         {
             T data;
-            uint32_t id = 0;
+            index pos;          // index in heap
+            uint8_t generation; // bumped whenever the slot is released
         };
-        vector<item, N> arr;
-        uint32_t count = 1;
+        slot slots[N];
+        index heap[N]; // heap[0, m_size) are live slots, the rest are free slots
+        index m_size = 0;
 
-    public:
-        int push(const T& v) noexcept
+        inline const T& at(index i) const noexcept
+        {
+            return slots[heap[i]].data;
+        }
+
+        inline void swap_at(index a, index b) noexcept
         {
-            int child = arr.size();
-            if (!arr.push({ v, count })) return 0;
+            swap(heap[a], heap[b]);
+            slots[heap[a]].pos = a;
+            slots[heap[b]].pos = b;
+        }
 
+        void sift_up(index child) noexcept
+        {
             while (child != 0)
             {
-                int parent = (child - 1) / 2;
+                index parent = (child - 1) / 2;
+                if (!(at(child) < at(parent))) break;
 
-                if (arr[child].data < arr[parent].data)
-                {
-                    swap(arr[child], arr[parent]);
-                }
+                swap_at(child, parent);
                 child = parent;
             }
-            return count++;
         }
 
-        bool pop() noexcept
+        void sift_down(index parent) noexcept
         {
-            if (empty()) return false;
-
+            index_type<2 * N> child; // 2 * parent + 1 needs 16 bits only for N > 127
+            while ((child = 2 * parent + 1) < m_size)
             {
-                item temp;
-                arr.pop(temp);
-                arr[0] = move(temp);
+                if (child + 1 < m_size && at(child) > at(child + 1))
+                    child++;
+
+                if (!(at(parent) > at(child))) break;
+
+                swap_at(parent, child);
+                parent = child;
             }
+        }
+
+        // removes the element at heap index i
+        void remove_at(index i) noexcept
+        {
+            slot& s = slots[heap[i]];
+            if (++s.generation == 0) s.generation = 1;
 
-            int n = arr.size();
-            int parent = 0, child;
-            while ((child = 2 * parent + 1) < n)
+            m_size--;
+            if (i != m_size)
             {
-                if (child + 1 < n && arr[child].data > arr[child + 1].data)
-                    child++;
-                
-                if (arr[parent].data > arr[child].data)
-                    swap(arr[parent], arr[child]);
+                const index moved = heap[m_size];
+                swap_at(i, m_size);
+                sift_up(i);
+                sift_down(slots[moved].pos);
+            }
+        }
 
-                parent = child;
+        // heap index of a live handle, or N if the handle is stale
+        index find(handle h) const noexcept
+        {
+            const index i = static_cast<uint8_t>(h);
+            if (i >= N) return N;
+
+            const slot& s = slots[i];
+            if (s.generation != static_cast<uint8_t>(h >> 8) || s.pos >= m_size) return N;
+            return s.pos;
+        }
+
+    public:
+        priority_queue() noexcept
+        {
+            for (index i = 0; i < N; i++)
+            {
+                heap[i] = i;
+                slots[i].pos = i;
+                slots[i].generation = 1;
             }
+        }
+
+        handle push(const T& v) noexcept
+        {
+            if (m_size >= N) return 0;
+
+            const index pos = m_size++;
+            const index i = heap[pos];
+            slots[i].data = v;
+            sift_up(pos);
+
+            return static_cast<handle>(slots[i].generation) << 8 | i;
+        }
+
+        bool pop() noexcept
+        {
+            if (empty()) return false;
+
+            remove_at(0);
             return true;
         }
 
@@ -65,20 +133,19 @@ namespace gb7
         {
             if (empty()) return false;
 
-            arr[0].data = move(v);
+            slots[heap[0]].data = v;
+            sift_down(0);
+            return true;
+        }
 
-            int n = arr.size();
-            int parent = 0, child;
-            while ((child = 2 * parent + 1) < n)
-            {
-                if (child + 1 < n && arr[child].data > arr[child + 1].data)
-                    child++;
-                
-                if (arr[parent].data > arr[child].data)
-                    swap(arr[parent], arr[child]);
+        bool update(handle h, const T& v) noexcept
+        {
+            const index i = find(h);
+            if (i == N) return false;
 
-                parent = child;
-            }
+            slots[heap[i]].data = v;
+            sift_up(i);
+            sift_down(slots[static_cast<uint8_t>(h)].pos);
             return true;
         }
 
@@ -86,45 +153,50 @@ namespace gb7
         {
             if (empty()) return false;
 
-            ret = arr[0].data;
+            ret = at(0);
             return true;
         }
 
         const T& top() const noexcept
         {
-            return arr[0].data;
+            return at(0);
         }
 
-        bool erase(uint32_t id) noexcept
+        // handle of the top element; 0 if the queue is empty
+        handle top_handle() const noexcept
         {
-            int i = arr.find([id](const item& v) { return v.id == id; });
-            if (i == -1) return false;
+            if (empty()) return 0;
 
-            {
-                item temp;
-                arr.pop(temp);
-                arr[i] = move(temp);
-            }
+            const index i = heap[0];
+            return static_cast<handle>(slots[i].generation) << 8 | i;
+        }
 
-            int n = arr.size();
-            int parent = i, child;
-            while ((child = 2 * parent + 1) < n)
-            {
-                if (child + 1 < n && arr[child].data > arr[child + 1].data)
-                    child++;
-                
-                if (arr[parent].data > arr[child].data)
-                    swap(arr[parent], arr[child]);
+        bool get(handle h, T& ret) const noexcept
+        {
+            const index i = find(h);
+            if (i == N) return false;
 
-                parent = child;
-            }
+            ret = at(i);
+            return true;
+        }
+
+        bool contains(handle h) const noexcept
+        {
+            return find(h) != N;
+        }
+
+        bool erase(handle h) noexcept
+        {
+            const index i = find(h);
+            if (i == N) return false;
 
+            remove_at(i);
             return true;
         }
 
         size_t size() const noexcept
         {
-            return arr.size();
+            return m_size;
         }
 
         bool empty() const noexcept
@@ -2,14 +2,22 @@
 #define QUEUE_HPP
 
 #include <stddef.h>
+#include "utils.hpp"
 
 namespace gb7
 {
     template<class T, size_t N = 16>
     class queue
     {
+        using index = index_type<N>;
+
         T arr[N];
-        size_t head = 0, tail = 0, m_size = 0;
+        index head = 0, tail = 0, m_size = 0;
+
+        static inline index next(index i) noexcept
+        {
+            return i + 1 == N ? 0 : i + 1;
+        }
 
     public:
         bool push(const T&& v) noexcept
@@ -17,7 +25,7 @@ namespace gb7
             if (m_size >= N) return false;
             
             arr[tail] = v;
-            tail = (tail + 1) % N;
+            tail = next(tail);
             m_size++;
             return true;
         }
@@ -27,7 +35,7 @@ namespace gb7
             if (m_size == 0) return false;
 
             auto head_temp = head;
-            head = (head + 1) % N;
+            head = next(head);
             ret = static_cast<T&&>(arr[head_temp]);
             m_size--;
             return true;
@@ -48,18 +56,18 @@ namespace gb7
         template<class Func>
         void each_of(Func func) // void func(T value, size_t index)
         {
-            for (size_t i=0; i < m_size; i++)
+            for (index i=0, j=head; i < m_size; i++, j=next(j))
             {
-                func(arr[(head + i) % N], i);
+                func(arr[j], i);
             }
         }
 
         template<class Func>
         bool all(Func func) // bool func(T value, size_t index)
         {
-            for (size_t i=0; i < m_size; i++)
+            for (index i=0, j=head; i < m_size; i++, j=next(j))
             {
-                if (!func(arr[(head + i) % N], i))
+                if (!func(arr[j], i))
                     return false;
             }
             return true;
@@ -68,9 +76,9 @@ namespace gb7
         template<class Func>
         bool any(Func func) // bool func(T value, size_t index)
         {
-            for (size_t i=0; i < m_size; i++)
+            for (index i=0, j=head; i < m_size; i++, j=next(j))
             {
-                if (func(arr[(head + i) % N], i))
+                if (func(arr[j], i))
                     return true;
             }
             return false;
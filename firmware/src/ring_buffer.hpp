@@ -0,0 +1,142 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gb7
+{
+    // Single-producer/single-consumer queue which is safe between the main loop
+    // and one ISR without disabling interrupts. The producer only writes `tail`
+    // and the consumer only writes `head`; both are free-running 8-bit counters,
+    // so every index load and store is a single instruction.
+    template<class T, size_t N = 16>
+    class ring_buffer
+    {
+        static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "ring_buffer capacity must be a power of two up to 128");
+        static constexpr uint8_t mask = N - 1;
+
+        T arr[N];
+        volatile uint8_t head = 0; // written by the consumer only
+        volatile uint8_t tail = 0; // written by the producer only
+
+        static inline void barrier() noexcept
+        {
+            asm volatile("" ::: "memory");
+        }
+
+    public:
+        /*
+         * producer side
+         */
+        bool push(const T& v) noexcept
+        {
+            const uint8_t t = tail;
+            if (static_cast<uint8_t>(t - head) >= N) return false;
+
+            arr[t & mask] = v;
+            barrier(); // publish the element before the index
+            tail = t + 1;
+            return true;
+        }
+
+        // Pushes as many of `count` elements as fit; returns how many were pushed.
+        size_t push(const T* data, size_t count) noexcept
+        {
+            const uint8_t t = tail;
+            const uint8_t space = N - static_cast<uint8_t>(t - head);
+            const uint8_t n = count < space ? count : space;
+
+            for (uint8_t i = 0; i < n; i++)
+                arr[static_cast<uint8_t>(t + i) & mask] = data[i];
+
+            barrier();
+            tail = t + n;
+            return n;
+        }
+
+        template<size_t M>
+        size_t push(const T (&data)[M]) noexcept
+        {
+            return push(data, M);
+        }
+
+        bool full() const noexcept
+        {
+            return static_cast<uint8_t>(tail - head) >= N;
+        }
+
+        /*
+         * consumer side
+         */
+        bool pop(T& ret) noexcept
+        {
+            const uint8_t h = head;
+            if (h == tail) return false;
+
+            barrier(); // read the element only after seeing the index
+            ret = static_cast<T&&>(arr[h & mask]);
+            barrier();
+            head = h + 1;
+            return true;
+        }
+
+        // Pops up to `count` elements into `data`; returns how many were popped.
+        size_t pop(T* data, size_t count) noexcept
+        {
+            const uint8_t h = head;
+            const uint8_t available = static_cast<uint8_t>(tail - h);
+            const uint8_t n = count < available ? count : available;
+
+            barrier();
+            for (uint8_t i = 0; i < n; i++)
+                data[i] = static_cast<T&&>(arr[static_cast<uint8_t>(h + i) & mask]);
+
+            barrier();
+            head = h + n;
+            return n;
+        }
+
+        template<size_t M>
+        size_t pop(T (&data)[M]) noexcept
+        {
+            return pop(data, M);
+        }
+
+        bool peek(T& ret) const noexcept
+        {
+            const uint8_t h = head;
+            if (h == tail) return false;
+
+            barrier();
+            ret = arr[h & mask];
+            return true;
+        }
+
+        // drops everything pushed so far
+        void clear() noexcept
+        {
+            head = tail;
+        }
+
+        bool empty() const noexcept
+        {
+            return head == tail;
+        }
+
+        /*
+         * either side
+         */
+        size_t size() const noexcept
+        {
+            return static_cast<uint8_t>(tail - head);
+        }
+
+        static constexpr size_t capacity() noexcept
+        {
+            return N;
+        }
+    };
+} // namespace gb7
+
+#endif // RING_BUFFER_HPP
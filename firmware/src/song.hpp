@@ -0,0 +1,192 @@
+#ifndef SONG_HPP
+#define SONG_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "speaker.hpp"
+
+namespace gb7::sound
+{
+    // A string literal usable as a template argument.
+    template<size_t N>
+    struct song_text
+    {
+        char data[N];
+
+        constexpr song_text(const char (&s)[N]) noexcept
+        {
+            for (size_t i = 0; i < N; i++) data[i] = s[i];
+        }
+    };
+
+    template<size_t N>
+    struct song_table
+    {
+        packed_note notes[N];
+    };
+
+    namespace song_parser
+    {
+        // Deliberately not constexpr: reaching it while parsing at compile time
+        // makes the song literal ill-formed, and the compiler reports the line
+        // which called it.
+        void syntax_error_in_song_text() noexcept;
+
+        struct line
+        {
+            bool empty;
+            Tone tone;
+            uint32_t length; // microseconds
+        };
+
+        struct tone_name
+        {
+            const char* name;
+            Tone tone;
+        };
+
+        constexpr tone_name tone_names[] = {
+            { "none", Tone::None },
+            { "c", Tone::C }, { "cs", Tone::Cs }, { "d", Tone::D }, { "ds", Tone::Ds },
+            { "e", Tone::E }, { "f", Tone::F }, { "fs", Tone::Fs }, { "g", Tone::G },
+            { "gs", Tone::Gs }, { "a", Tone::A }, { "as", Tone::As }, { "b", Tone::B },
+            { "ch", Tone::Ch },
+        };
+
+        constexpr bool is_space(char c) noexcept
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+        constexpr bool is_digit(char c) noexcept
+        {
+            return c >= '0' && c <= '9';
+        }
+        constexpr char to_lower(char c) noexcept
+        {
+            return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+        }
+
+        // matches [begin, end) case-insensitively against the tone names
+        constexpr Tone parse_tone(const char* begin, const char* end) noexcept
+        {
+            for (const tone_name& t : tone_names)
+            {
+                const char* p = begin;
+                const char* n = t.name;
+                while (p != end && *n != '\0' && to_lower(*p) == *n)
+                {
+                    p++;
+                    n++;
+                }
+                if (p == end && *n == '\0') return t.tone;
+            }
+
+            syntax_error_in_song_text(); // unknown tone
+            return Tone::None;
+        }
+
+        // `Tone: seconds`, or only spaces
+        constexpr line parse_line(const char* p, const char* end) noexcept
+        {
+            while (p != end && is_space(*p)) p++;
+            if (p == end) return { true, Tone::None, 0 };
+
+            const char* name = p;
+            while (p != end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))) p++;
+            const Tone tone = parse_tone(name, p);
+
+            while (p != end && is_space(*p)) p++;
+            if (p == end || *p != ':') syntax_error_in_song_text(); // missing ':'
+            p++;
+            while (p != end && is_space(*p)) p++;
+
+            uint32_t seconds = 0;
+            uint32_t micros = 0;
+            bool digits = false;
+            for (; p != end && is_digit(*p); p++)
+            {
+                seconds = seconds * 10 + (*p - '0');
+                if (seconds > 4000) syntax_error_in_song_text(); // too long for a 32-bit microsecond count
+                digits = true;
+            }
+            if (p != end && *p == '.')
+            {
+                p++;
+                uint32_t scale = 100000;
+                for (; p != end && is_digit(*p); p++)
+                {
+                    micros += (*p - '0') * scale; // digits below a microsecond are dropped
+                    scale /= 10;
+                    digits = true;
+                }
+            }
+            if (!digits) syntax_error_in_song_text(); // missing length
+
+            while (p != end && is_space(*p)) p++;
+            if (p != end) syntax_error_in_song_text(); // trailing characters
+
+            return { false, tone, seconds * 1000000 + micros };
+        }
+
+        // Calls f(line) for each non-empty line of the NUL-terminated text.
+        template<class Func>
+        constexpr void each_line(const char* text, Func f) noexcept
+        {
+            const char* begin = text;
+            while (true)
+            {
+                const char* end = begin;
+                while (*end != '\0' && *end != '\n') end++;
+
+                const line l = parse_line(begin, end);
+                if (!l.empty) f(l);
+
+                if (*end == '\0') return;
+                begin = end + 1;
+            }
+        }
+
+        constexpr size_t count(const char* text) noexcept
+        {
+            size_t n = 0;
+            each_line(text, [&n](const line&) { n++; });
+            if (n == 0) syntax_error_in_song_text(); // no notes
+            return n;
+        }
+
+        template<size_t N>
+        constexpr song_table<N> compile(const char* text) noexcept
+        {
+            song_table<N> table {};
+            size_t i = 0;
+            each_line(text, [&](const line& l) { table.notes[i++] = note(l.tone, l.length); });
+            return table;
+        }
+
+        template<song_text S>
+        inline constexpr song_table<count(S.data)> table PROGMEM = compile<count(S.data)>(S.data);
+    } // namespace song_parser
+
+    // Compiles the `Tone: seconds` text of sound_effect/index.html into a
+    // packed_note table in flash; the device only reads precomputed ticks.
+    //   constexpr char tune_text[] = "C: 0.5\nD: 0.5\nNone: 0.25\n";
+    //   sp.play(song<tune_text>());
+    template<song_text S>
+    constexpr note_sequence song() noexcept
+    {
+        return make_sequence(song_parser::table<S>.notes);
+    }
+
+    namespace literals
+    {
+        //   sp.play("C: 0.5\nD: 0.5\nNone: 0.25\n"_song);
+        template<song_text S>
+        constexpr note_sequence operator""_song() noexcept
+        {
+            return song<S>();
+        }
+    } // namespace literals
+} // namespace gb7::sound
+
+#endif // SONG_HPP
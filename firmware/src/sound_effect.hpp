@@ -2,6 +2,7 @@
 #define SOUND_EFFECT_HPP
 
 #include "speaker.hpp"
+#include "song.hpp"
 
 namespace gb7::sound
 {
@@ -11,17 +12,81 @@ namespace gb7::sound
         Tulip,
     };
 
+    namespace sound_effects
+    {
+        // kept as text so that host/render can compare against the ideal pitch and timing
+        inline constexpr char hit_text[] = R"(
+C: 0.1
+E: 0.1
+G: 0.1
+)";
+        inline constexpr note_sequence hit = song<hit_text>();
+
+        inline constexpr char tulip_text[] = R"(
+C: 0.5
+D: 0.5
+E: 0.5
+None: 0.5
+C: 0.5
+D: 0.5
+E: 0.5
+None: 0.5
+
+G: 0.5
+E: 0.5
+D: 0.5
+C: 0.5
+D: 0.5
+E: 0.5
+D: 0.5
+None: 0.5
+
+C: 0.5
+D: 0.5
+E: 0.5
+None: 0.5
+C: 0.5
+D: 0.5
+E: 0.5
+None: 0.5
+
+G: 0.5
+E: 0.5
+D: 0.5
+C: 0.5
+D: 0.5
+E: 0.5
+C: 0.5
+None: 0.5
+
+G: 0.5
+None: 0.001
+G: 0.5
+E: 0.5
+G: 0.5
+A: 0.5
+None: 0.001
+A: 0.5
+G: 0.5
+None: 0.5
+
+E: 0.5
+None: 0.001
+E: 0.5
+D: 0.5
+None: 0.001
+D: 0.5
+Ch: 1.0
+)";
+        inline constexpr note_sequence tulip = song<tulip_text>();
+    } // namespace sound_effects
+
     template<class SpeakerPin>
     class sound_effect
     {
         speaker<SpeakerPin> sp;
 
     public:
-        void init()
-        {
-            sp.init();
-        }
-
         void stop()
         {
             sp.stop_note();
@@ -32,66 +97,11 @@ namespace gb7::sound
             switch (type)
             {
             case SoundEffectType::Hit:
-                sp.enqueue_note(Tone::C, 0.1e6);
-                sp.enqueue_note(Tone::E, 0.1e6);
-                sp.enqueue_note(Tone::G, 0.1e6);
+                sp.play(sound_effects::hit);
                 return true;
 
             case SoundEffectType::Tulip:
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-
-                sp.enqueue_note(Tone::G    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-
-                sp.enqueue_note(Tone::G    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::C    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-
-                sp.enqueue_note(Tone::G    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.001e6);
-                sp.enqueue_note(Tone::G    , 0.5e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::G    , 0.5e6);
-                sp.enqueue_note(Tone::A    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.001e6);
-                sp.enqueue_note(Tone::A    , 0.5e6);
-                sp.enqueue_note(Tone::G    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.5e6);
-
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.001e6);
-                sp.enqueue_note(Tone::E    , 0.5e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::None , 0.001e6);
-                sp.enqueue_note(Tone::D    , 0.5e6);
-                sp.enqueue_note(Tone::Ch   , 1.0e6);
+                sp.play(sound_effects::tulip);
                 return true;
             }
             return false;
@@ -3,9 +3,10 @@
 
 #define GB7_TIMER_USE_INVOKE
 
+#include <avr/pgmspace.h>
 #include "port.hpp"
 #include "timer.hpp"
-#include "queue.hpp"
+#include "ring_buffer.hpp"
 
 namespace gb7::sound
 {
@@ -27,45 +28,110 @@ namespace gb7::sound
         Ch   = 1911,
     };
 
-    template<class SpeakerPin>
-    class speaker
+    // One note of a sequence in flash: `count` half periods of `half_period`
+    // multitimer ticks each. Build them with note(), which also splits long
+    // rests so that they fit. In a hand-written note a count or half period
+    // of 0 is played as 1.
+    struct packed_note
     {
-        struct Note
+        static constexpr uint16_t rest_bit = 0x8000; // in half_period: the pin stays low
+
+        uint16_t half_period;
+        uint16_t count;
+    };
+
+    constexpr packed_note note(Tone tone, uint32_t length) noexcept // length in microseconds
+    {
+        using namespace gb7::timer;
+        const uint32_t ticks = to_ticks(microseconds(length));
+
+        if (tone == Tone::None)
         {
-            Tone tone;
-            uint32_t length; // microseconds
+            const uint32_t total = ticks > 0 ? ticks : 1;
+            const uint32_t parts = (total + 0x7ffe) / 0x7fff;
+            return { static_cast<uint16_t>(packed_note::rest_bit | (total / parts)), static_cast<uint16_t>(parts) };
+        }
+
+        // the half period is rounded to whole ticks; the count keeps the note length right
+        uint32_t half = to_ticks(duration<1, 2000000>(static_cast<uint32_t>(tone)));
+        half = half > 0 ? (half < 0x7fff ? half : 0x7fff) : 1;
+        const uint32_t count = (ticks + half / 2) / half;
+        return {
+            static_cast<uint16_t>(half),
+            static_cast<uint16_t>(count > 0 ? (count < 0xffff ? count : 0xffff) : 1),
         };
+    }
+
+    // A packed_note array in PROGMEM:
+    //   const packed_note tune[] PROGMEM = { note(Tone::C, 500000), ... };
+    //   sp.play(make_sequence(tune));
+    struct note_sequence
+    {
+        const packed_note* notes;
+        uint16_t length;
+    };
 
-        queue<Note, 16> m_notes;
-        Tone m_tone = Tone::None;
-        uint32_t m_count = 0;
-        uint32_t m_count_to = 0;
-        uint32_t timer_id = 0;
+    template<size_t N>
+    constexpr note_sequence make_sequence(const packed_note (&notes)[N]) noexcept
+    {
+        static_assert(N <= 0xffff, "sequence too long");
+        return { notes, static_cast<uint16_t>(N) };
+    }
+
+    // Square-wave speaker on any pin, toggled from multitimer. The notes are
+    // read from flash one at a time at note boundaries, so a sequence of any
+    // length costs no RAM per note.
+    template<class SpeakerPin>
+    class speaker
+    {
+        const packed_note* m_next = nullptr; // PROGMEM
+        uint16_t m_left = 0;  // notes after the current one
+        uint16_t m_count = 0; // half periods left in the current note
+        bool m_rest = false;
+        gb7::timer::timer_node m_node { on_timer<SpeakerPin>, this };
 
     public:
         speaker()
         {
             gb7::timer::multitimer::init();
-
-            using namespace gb7::timer::literals;
-            timer_id = gb7::timer::multitimer::invoke_every(100_ms, 0, on_timer<SpeakerPin>, this);
         }
         ~speaker()
         {
-            gb7::timer::multitimer::cancel_invocation(timer_id);
+            stop_note();
         }
 
-        inline void stop_note()
+        // Starts `seq`, replacing whatever is playing.
+        inline void play(const note_sequence& seq)
         {
-            m_notes.clear();
-            m_tone = Tone::None;
-            m_count = 0;
-            m_count_to = 0;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                m_next = seq.notes;
+                m_left = seq.length;
+                m_count = 0;
+                gb7::timer::multitimer::schedule_in(m_node, 0);
+            }
         }
 
-        inline bool enqueue_note(Tone tone, uint32_t length)
+        inline bool playing() const
         {
-            return m_notes.push({ tone, length });
+            return m_node.scheduled();
+        }
+
+        // notes of the sequence still to start after the current one
+        inline uint16_t notes_left() const
+        {
+            return m_left;
+        }
+
+        inline void stop_note()
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                gb7::timer::multitimer::cancel(m_node);
+                m_left = 0;
+                m_count = 0;
+                SpeakerPin {}.set_low();
+            }
         }
 
         template<class SpeakerPin_>
@@ -74,54 +140,178 @@ namespace gb7::sound
             SpeakerPin_ pin;
             auto sp = static_cast<speaker<SpeakerPin_>*>(d);
 
-            if(sp->m_count < sp->m_count_to)
+            if (sp->m_count > 0)
+            {
+                sp->m_count--;
+                if (!sp->m_rest) pin.toggle();
+                return;
+            }
+
+            // note boundary
+            if (sp->m_left == 0)
+            {
+                pin.set_low();
+                gb7::timer::multitimer::cancel(sp->m_node);
+                return;
+            }
+
+            uint16_t half_period = pgm_read_word(&sp->m_next->half_period);
+            if ((half_period & ~packed_note::rest_bit) == 0) half_period |= 1;
+            const uint16_t count = pgm_read_word(&sp->m_next->count);
+            sp->m_count = count > 0 ? count - 1 : 0;
+            sp->m_next++;
+            sp->m_left--;
+
+            sp->m_rest = half_period & packed_note::rest_bit;
+            if (sp->m_rest) pin.set_low();
+            else pin.toggle();
+
+            gb7::timer::multitimer::schedule_every(sp->m_node, half_period & ~packed_note::rest_bit, half_period & ~packed_note::rest_bit);
+        }
+    };
+
+    // Notes queued by the main loop and started one at a time from the timer
+    // ISR. Lengths are converted to ticks when a note is queued, so the ISR
+    // only pops and reschedules. `f(d)` runs in the timer ISR at every note
+    // boundary and calls next().
+    template<size_t N>
+    class note_queue
+    {
+        struct queued_note
+        {
+            Tone tone;
+            gb7::timer::time_unit ticks;
+        };
+
+        ring_buffer<queued_note, N> m_notes; // pushed by the main loop, popped in the timer ISR
+        gb7::timer::timer_node m_node;
+
+    public:
+        note_queue(gb7::timer::callback_func f, void* d) noexcept : m_node(f, d) {}
+
+        // Queues a note of `length` microseconds; main loop only.
+        bool push(Tone tone, uint32_t length) noexcept
+        {
+            if (!m_notes.push({ tone, gb7::timer::to_ticks(gb7::timer::microseconds(length)) })) return false;
+
+            // idle until now; the ISR cannot pop in between since the node is not scheduled
+            if (!m_node.scheduled()) gb7::timer::multitimer::schedule_in(m_node, 0);
+            return true;
+        }
+
+        // Takes the next note and schedules the boundary after it; false if
+        // the queue ran empty. Called from the boundary callback.
+        bool next(Tone& tone) noexcept
+        {
+            queued_note n;
+            if (!m_notes.pop(n)) return false;
+
+            tone = n.tone;
+            gb7::timer::multitimer::schedule_in(m_node, n.ticks);
+            return true;
+        }
+
+        // Drops every queued note. Call with interrupts disabled.
+        void clear() noexcept
+        {
+            m_notes.clear();
+            gb7::timer::multitimer::cancel(m_node);
+        }
+    };
+
+    // Speaker on OC0A (PD6). Timer0 makes the square wave in CTC mode with
+    // toggle on match, so software only reprograms it at note boundaries.
+    class tone_speaker
+    {
+        struct tone_setting
+        {
+            gb7::timer::raw_timers::clock_division division;
+            uint8_t top;
+        };
+
+        note_queue<16> m_notes { on_timer, this };
+
+        // Smallest prescaler whose counter still holds half a period, which
+        // keeps the rounding error below half a count.
+        static constexpr tone_setting setting_for(Tone tone) noexcept
+        {
+            using gb7::timer::raw_timers::clock_division;
+            constexpr struct
             {
-                sp->m_count++;
-                if (sp->m_tone != Tone::None)
-                {
-                    pin = !pin;
-                }
+                uint8_t shift;
+                clock_division division;
+            } prescalers[] = {
+                { 0, clock_division::no_division },
+                { 3, clock_division::division_8 },
+                { 6, clock_division::division_64 },
+                { 8, clock_division::division_256 },
+                { 10, clock_division::division_1024 },
+            };
+
+            const uint32_t half_period = static_cast<uint32_t>(tone) * (F_CPU / 1000) / 2000; // cycles
+            for (const auto& p : prescalers)
+            {
+                const uint32_t counts = (half_period + ((1ul << p.shift) >> 1)) >> p.shift;
+                if (counts <= 256) return { p.division, static_cast<uint8_t>(counts > 0 ? counts - 1 : 0) };
             }
-            else
+            return { clock_division::division_1024, 0xff };
+        }
+
+        static void start_tone(Tone tone) noexcept
+        {
+            using namespace gb7::timer::raw_timers;
+            const tone_setting s = setting_for(tone);
+
+            // stop the clock first so the counter never runs past a lower top
+            raw_timer0::init(pwm_mode::toggle_on_match, pwm_mode::none, timer_mode::ctc, timer_top::ff, clock_division::no_clock);
+            raw_timer0::set_count(0);
+            raw_timer0::set_ctc_top(s.top);
+            raw_timer0::init(pwm_mode::toggle_on_match, pwm_mode::none, timer_mode::ctc, timer_top::ff, s.division);
+        }
+
+        static void stop_tone() noexcept
+        {
+            using namespace gb7::timer::raw_timers;
+            raw_timer0::init(pwm_mode::none, pwm_mode::none, timer_mode::normal, timer_top::ff, clock_division::no_clock);
+            PORTD &= ~(1 << 6);
+        }
+
+    public:
+        tone_speaker()
+        {
+            gb7::timer::multitimer::init();
+
+            stop_tone();
+            DDRD |= (1 << 6);
+        }
+        ~tone_speaker()
+        {
+            stop_note();
+        }
+
+        inline void stop_note()
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
             {
-                if (!sp->m_notes.empty())
-                {
-                    Note note_temp;
-                    sp->m_notes.pop(note_temp);
-
-                    if (note_temp.tone == Tone::None)
-                    {
-                        sp->m_tone = Tone::None;
-                        sp->m_count = 0;
-                        sp->m_count_to = 0;
-
-                        gb7::timer::multitimer::cancel_invocation(sp->timer_id);
-                        sp->timer_id = gb7::timer::multitimer::invoke_every(gb7::timer::literals::operator""_us(note_temp.length), 0, on_timer<SpeakerPin_>, d);
-                    }
-                    else
-                    {
-                        sp->m_tone = note_temp.tone;
-                        sp->m_count_to = 2 * note_temp.length / static_cast<int>(sp->m_tone);
-                        sp->m_count = 0;
-
-                        gb7::timer::multitimer::cancel_invocation(sp->timer_id);
-                        sp->timer_id = gb7::timer::multitimer::invoke_every(gb7::timer::literals::operator""_us(static_cast<int>(sp->m_tone) / 2), 0, on_timer<SpeakerPin_>, d);
-                    }
-                }
-                else
-                {
-                    sp->m_tone = Tone::None;
-                    sp->m_count_to = 0;
-                    sp->m_count = 0;
-
-                    pin.set_low();
-
-                    gb7::timer::multitimer::cancel_invocation(sp->timer_id);
-                    using namespace gb7::timer::literals;
-                    sp->timer_id = gb7::timer::multitimer::invoke_in(100_ms, on_timer<SpeakerPin_>, d);
-                }
+                m_notes.clear();
+                stop_tone();
             }
         }
+
+        // Queues a note of `length` microseconds.
+        inline bool enqueue_note(Tone tone, uint32_t length)
+        {
+            return m_notes.push(tone, length);
+        }
+
+        static void on_timer(void* d)
+        {
+            auto sp = static_cast<tone_speaker*>(d);
+
+            Tone tone;
+            if (!sp->m_notes.next(tone) || tone == Tone::None) stop_tone();
+            else start_tone(tone);
+        }
     };
 } // namespace gb7::sound
 
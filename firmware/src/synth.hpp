@@ -0,0 +1,249 @@
+#ifndef SYNTH_HPP
+#define SYNTH_HPP
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+#define GB7_TIMER_USE_INVOKE
+
+#include "timer.hpp"
+#include "speaker.hpp"
+
+// Number of voices mixed per sample; a power of two up to 8.
+#ifndef GB7_SYNTH_CHANNELS
+#define GB7_SYNTH_CHANNELS 4
+#endif // GB7_SYNTH_CHANNELS
+
+// One sample every GB7_SYNTH_DIVIDER Timer0 overflows (256 cycles each),
+// i.e. 7812.5 Hz at 8 MHz with the default of 4.
+#ifndef GB7_SYNTH_DIVIDER
+#define GB7_SYNTH_DIVIDER 4
+#endif // GB7_SYNTH_DIVIDER
+
+
+namespace gb7::sound
+{
+    enum class waveform: uint8_t
+    {
+        square,
+        triangle,
+        noise,
+    };
+
+    // one period of a waveform as signed 8-bit samples
+    struct wavetable
+    {
+        int8_t data[256];
+    };
+
+    namespace wavetables
+    {
+        constexpr wavetable make_square() noexcept
+        {
+            wavetable t {};
+            for (int i = 0; i < 256; i++) t.data[i] = i < 128 ? 127 : -128;
+            return t;
+        }
+
+        constexpr wavetable make_triangle() noexcept
+        {
+            wavetable t {};
+            for (int i = 0; i < 256; i++) t.data[i] = static_cast<int8_t>(i < 128 ? -128 + 2 * i : 383 - 2 * i);
+            return t;
+        }
+
+        // 8-bit Galois LFSR; repeats every period, which gives pitched noise
+        constexpr wavetable make_noise() noexcept
+        {
+            wavetable t {};
+            uint8_t lfsr = 0xa5;
+            for (int i = 0; i < 256; i++)
+            {
+                lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xb8);
+                t.data[i] = static_cast<int8_t>(lfsr);
+            }
+            return t;
+        }
+
+        inline const wavetable square PROGMEM = make_square();
+        inline const wavetable triangle PROGMEM = make_triangle();
+        inline const wavetable noise PROGMEM = make_noise();
+    } // namespace wavetables
+
+    // N-voice wavetable synthesizer. Timer0 runs undivided in fast PWM and
+    // OC0A (PD6) is the 8-bit DAC output, to be followed by an RC low-pass.
+    // The overflow ISR mixes one sample every GB7_SYNTH_DIVIDER overflows.
+    //
+    // Per-sample cost, an unmeasured estimate from counting instructions (run
+    // `make bench` for real numbers): about 25 cycles per voice plus about 45
+    // for the ISR entry, exit and output, so 4 voices take about 145 of the
+    // 1024 cycles between samples. The other overflows cost about 20 cycles
+    // each, about 20% of the CPU at 8 MHz in total. The cost does not depend
+    // on the notes played.
+    //
+    // Timer0 is shared with tone_speaker, so use one or the other.
+    class synth
+    {
+        static_assert(GB7_SYNTH_CHANNELS > 0 && GB7_SYNTH_CHANNELS <= 8 && (GB7_SYNTH_CHANNELS & (GB7_SYNTH_CHANNELS - 1)) == 0,
+            "GB7_SYNTH_CHANNELS must be 1, 2, 4 or 8");
+        static_assert(GB7_SYNTH_DIVIDER > 0 && GB7_SYNTH_DIVIDER < 256, "GB7_SYNTH_DIVIDER must fit in 8 bits");
+
+    public:
+        static constexpr uint8_t channels = GB7_SYNTH_CHANNELS;
+        // phase increment for 1 Hz is 65536 / sample rate; scaled by 1e6 for Tone periods
+        static constexpr uint32_t increment_scale = static_cast<uint32_t>(65536ull * 256 * GB7_SYNTH_DIVIDER * 1000000 / F_CPU);
+
+    private:
+        // read by the ISR; written by the main loop with interrupts disabled
+        struct channel_state
+        {
+            uint16_t phase;
+            uint16_t increment; // 8.8 fixed point samples per output sample
+            const int8_t* wave; // PROGMEM
+            uint8_t volume;
+        };
+
+        struct voice
+        {
+            note_queue<8> notes;
+
+            voice() noexcept : notes(on_note_end, this) {}
+        };
+
+        static inline channel_state state[channels];
+        static inline voice voices[channels];
+        static inline uint8_t divider = GB7_SYNTH_DIVIDER;
+
+        static constexpr uint8_t mix_shift = channels >= 8 ? 3 : channels >= 4 ? 2 : channels >= 2 ? 1 : 0;
+
+        static const int8_t* table_of(waveform w) noexcept
+        {
+            switch (w)
+            {
+            case waveform::triangle: return wavetables::triangle.data;
+            case waveform::noise:    return wavetables::noise.data;
+            default:                 return wavetables::square.data;
+            }
+        }
+
+        static void on_note_end(void* d)
+        {
+            voice* v = static_cast<voice*>(d);
+            const uint8_t ch = v - voices;
+
+            Tone tone;
+            state[ch].increment = v->notes.next(tone) ? increment_of(tone) : 0;
+        }
+
+    public:
+        synth() = delete;
+
+        static void init() noexcept
+        {
+            using namespace gb7::timer::raw_timers;
+
+            gb7::timer::multitimer::init();
+
+            for (uint8_t i = 0; i < channels; i++)
+            {
+                state[i] = { 0, 0, wavetables::square.data, 0 };
+            }
+
+            raw_timer0::set_compare_match_a(128);
+            raw_timer0::init(pwm_mode::low_on_match, pwm_mode::none, timer_mode::fast_pwm, timer_top::ff, clock_division::no_division);
+            raw_timer0::enable_overflow_interrupt();
+            DDRD |= (1 << 6);
+            sei();
+        }
+
+        // 0 for Tone::None, which silences the channel without losing its phase
+        static uint16_t increment_of(Tone tone) noexcept
+        {
+            return tone == Tone::None ? 0 : static_cast<uint16_t>(increment_scale / static_cast<uint32_t>(tone));
+        }
+
+        static void set_waveform(uint8_t ch, waveform w) noexcept
+        {
+            const int8_t* table = table_of(w);
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                state[ch].wave = table;
+            }
+        }
+
+        // 0 is silent, 255 is full scale for this channel
+        static void set_volume(uint8_t ch, uint8_t volume) noexcept
+        {
+            state[ch].volume = volume; // a single byte store needs no lock
+        }
+
+        // Plays `tone` until changed; does not touch the note queue.
+        static void play(uint8_t ch, Tone tone) noexcept
+        {
+            const uint16_t inc = increment_of(tone);
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                state[ch].increment = inc;
+            }
+        }
+
+        // Queues a note of `length` microseconds on a channel.
+        static bool enqueue_note(uint8_t ch, Tone tone, uint32_t length) noexcept
+        {
+            return voices[ch].notes.push(tone, length);
+        }
+
+        static void stop(uint8_t ch) noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                voices[ch].notes.clear();
+                state[ch].increment = 0;
+            }
+        }
+
+        // Mixes the next output sample; the mix is divided by the channel count,
+        // so full-volume voices never clip.
+        static uint8_t next_sample() noexcept
+        {
+            int16_t mix = 0;
+#pragma GCC unroll 8
+            for (uint8_t i = 0; i < channels; i++)
+            {
+                channel_state& c = state[i];
+                c.phase += c.increment;
+                const int8_t s = pgm_read_byte(c.wave + (c.phase >> 8));
+                mix += (s * c.volume) >> 8;
+            }
+            return static_cast<uint8_t>((mix >> mix_shift) + 128);
+        }
+
+        static void on_overflow() noexcept
+        {
+            if (--divider != 0) return;
+
+            divider = GB7_SYNTH_DIVIDER;
+            // OCR0A is double buffered and takes the value at the next BOTTOM
+            gb7::timer::raw_timers::raw_timer0::set_compare_match_a(next_sample());
+        }
+    };
+} // namespace gb7::sound
+
+
+#ifdef GB7_SYNTH_USE_ISR
+
+ISR(TIMER0_OVF_vect)
+{
+    gb7::sound::synth::on_overflow();
+}
+
+#else
+
+#warning "GB7_SYNTH_USE_ISR must be defined elsewhere."
+
+#endif // GB7_SYNTH_USE_ISR
+
+#endif // SYNTH_HPP
@@ -0,0 +1,374 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+// Cooperative tasks on C++20 coroutines, resumed by multitimer.
+// Needs a compiler with coroutine support (avr-gcc 10 or later with -fcoroutines,
+// which the Makefile passes).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <util/atomic.h>
+
+#define GB7_TIMER_USE_INVOKE
+
+#include "timer.hpp"
+#include "queue.hpp"
+#include "pool_allocator.hpp"
+#include "power.hpp"
+
+#ifndef GB7_TASK_COUNT
+#define GB7_TASK_COUNT 4
+#endif // GB7_TASK_COUNT
+
+// Bytes per coroutine frame; see detail::default_frame_size. A task whose
+// frame is larger fails to build, or at -O0 cannot be created and is counted
+// in scheduler::oversized_frames().
+#ifndef GB7_TASK_FRAME_SIZE
+#define GB7_TASK_FRAME_SIZE (gb7::coro::detail::default_frame_size)
+#endif // GB7_TASK_FRAME_SIZE
+
+
+#if __has_include(<coroutine>)
+#include <coroutine>
+#else
+// avr-libc ships no C++ library, so provide the parts of <coroutine> the compiler needs.
+namespace std
+{
+    template<class R, class... Args>
+    struct coroutine_traits
+    {
+        using promise_type = typename R::promise_type;
+    };
+
+    template<class Promise = void>
+    struct coroutine_handle;
+
+    template<>
+    struct coroutine_handle<void>
+    {
+        constexpr coroutine_handle() noexcept = default;
+
+        static coroutine_handle from_address(void* address) noexcept
+        {
+            coroutine_handle h;
+            h.ptr = address;
+            return h;
+        }
+
+        void* address() const noexcept { return ptr; }
+        explicit operator bool() const noexcept { return ptr != nullptr; }
+
+        bool done() const noexcept { return __builtin_coro_done(ptr); }
+        void resume() const { __builtin_coro_resume(ptr); }
+        void operator()() const { resume(); }
+        void destroy() const { __builtin_coro_destroy(ptr); }
+
+    protected:
+        void* ptr = nullptr;
+    };
+
+    template<class Promise>
+    struct coroutine_handle: coroutine_handle<void>
+    {
+        static coroutine_handle from_address(void* address) noexcept
+        {
+            coroutine_handle h;
+            h.ptr = address;
+            return h;
+        }
+
+        static coroutine_handle from_promise(Promise& p) noexcept
+        {
+            coroutine_handle h;
+            h.ptr = __builtin_coro_promise(reinterpret_cast<char*>(&p), __alignof(Promise), true);
+            return h;
+        }
+
+        Promise& promise() const noexcept
+        {
+            return *static_cast<Promise*>(__builtin_coro_promise(ptr, __alignof(Promise), false));
+        }
+    };
+
+    struct suspend_always
+    {
+        constexpr bool await_ready() const noexcept { return false; }
+        constexpr void await_suspend(coroutine_handle<>) const noexcept {}
+        constexpr void await_resume() const noexcept {}
+    };
+
+    struct suspend_never
+    {
+        constexpr bool await_ready() const noexcept { return true; }
+        constexpr void await_suspend(coroutine_handle<>) const noexcept {}
+        constexpr void await_resume() const noexcept {}
+    };
+} // namespace std
+#endif // __has_include(<coroutine>)
+
+
+namespace gb7::coro
+{
+    class scheduler;
+
+
+    /*
+     * awaitables which do not depend on the scheduler
+     */
+
+    // co_await sleep_for(50_ms); or sleep_for(timer::milliseconds(50))
+    class sleep_for
+    {
+        timer::timer_node node { on_timer, this, timer::dispatch_mode::deferred };
+        timer::time_unit ticks;
+        std::coroutine_handle<> h;
+
+        static void on_timer(void* d)
+        {
+            static_cast<sleep_for*>(d)->h.resume();
+        }
+
+    public:
+        explicit sleep_for(timer::time_unit t) noexcept : ticks(t) {}
+        template<uint32_t N, uint32_t D>
+        explicit sleep_for(timer::duration<N, D> t) noexcept : ticks(timer::to_ticks(t)) {}
+
+        bool await_ready() const noexcept
+        {
+            return ticks == 0;
+        }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            h = handle;
+            timer::multitimer::schedule_in(node, ticks);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    // bool level = co_await pin_change(button); or pin_change(button, 5_ms)
+    // The pin is sampled in the timer ISR every poll interval, 1ms by default,
+    // and the task resumes in the main loop with the new level. It polls
+    // rather than waiting for a pin change interrupt, since pcint.hpp queues
+    // its edges for the application to poll and a waiting task must not take
+    // them; polling also works on every pin without claiming a PCINT vector.
+    template<class Pin>
+    class pin_change
+    {
+        timer::timer_node poll { on_poll, this };
+        timer::timer_node wake { on_wake, this, timer::dispatch_mode::deferred };
+        timer::time_unit interval;
+        bool level = false;
+        std::coroutine_handle<> h;
+
+        static void on_poll(void* d)
+        {
+            auto self = static_cast<pin_change*>(d);
+            if (Pin {}.read() != self->level)
+            {
+                self->level = !self->level;
+                timer::multitimer::cancel(self->poll);
+                timer::multitimer::schedule_in(self->wake, 0);
+            }
+        }
+
+        static void on_wake(void* d)
+        {
+            static_cast<pin_change*>(d)->h.resume();
+        }
+
+    public:
+        explicit pin_change(Pin, timer::time_unit poll_interval) noexcept : interval(poll_interval > 0 ? poll_interval : 1) {}
+        template<uint32_t N = 1, uint32_t D = 1000>
+        explicit pin_change(Pin p, timer::duration<N, D> poll_interval = timer::milliseconds(1)) noexcept
+            : pin_change(p, timer::to_ticks(poll_interval)) {}
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            h = handle;
+            level = Pin {}.read();
+            timer::multitimer::schedule_every(poll, interval, interval);
+        }
+        bool await_resume() const noexcept
+        {
+            return level;
+        }
+    };
+
+    namespace detail
+    {
+        struct any_pin
+        {
+            bool read() const noexcept { return false; }
+        };
+
+        // Besides the locals, a frame holds the resume and destroy pointers,
+        // the promise, the suspend point and a few compiler temporaries, and
+        // gcc gives every co_await in the body its own awaiter slot. The
+        // default fits a task awaiting one pin_change and one sleep_for.
+        inline constexpr size_t frame_header_size = 6 * sizeof(void*);
+        inline constexpr size_t frame_locals_size = 16;
+        inline constexpr size_t default_frame_size = frame_header_size + frame_locals_size
+            + sizeof(pin_change<any_pin>) + sizeof(sleep_for);
+
+        void frame_too_large() __attribute__((error("a coroutine frame is larger than GB7_TASK_FRAME_SIZE")));
+    } // namespace detail
+
+    // Return type of a task coroutine. The task starts suspended and runs once
+    // it is handed to scheduler::spawn(); its frame comes from a static pool
+    // and is released when the coroutine returns.
+    class task
+    {
+    public:
+        struct promise_type
+        {
+            static inline fixed_pool<GB7_TASK_FRAME_SIZE, GB7_TASK_COUNT> frames;
+            static inline uint8_t oversized = 0;
+
+            static void* operator new(size_t size) noexcept
+            {
+                // the frame size is a constant once this is inlined into the coroutine
+                if (__builtin_constant_p(size) && size > GB7_TASK_FRAME_SIZE) detail::frame_too_large();
+                if (size > GB7_TASK_FRAME_SIZE)
+                {
+                    if (oversized != 0xff) oversized++;
+                    return nullptr;
+                }
+
+                void* p;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    p = frames.allocate();
+                }
+                return p;
+            }
+            static void operator delete(void* ptr) noexcept
+            {
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    frames.deallocate(ptr);
+                }
+            }
+            static task get_return_object_on_allocation_failure() noexcept
+            {
+                return task {};
+            }
+
+            task get_return_object() noexcept
+            {
+                return task { std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept {}
+        };
+
+        task() noexcept = default;
+        task(task&& t) noexcept : h(t.h)
+        {
+            t.h = {};
+        }
+        task(const task&) = delete;
+        task& operator=(const task&) = delete;
+
+        // a task which was never spawned is destroyed with its owner
+        ~task()
+        {
+            if (h) h.destroy();
+        }
+
+        // false if no frame could be allocated
+        explicit operator bool() const noexcept
+        {
+            return static_cast<bool>(h);
+        }
+
+    private:
+        friend class scheduler;
+
+        explicit task(std::coroutine_handle<promise_type> handle) noexcept : h(handle) {}
+
+        std::coroutine_handle<promise_type> h;
+    };
+
+    // Runs spawned and yielding tasks from the main loop. Tasks waiting on time
+    // or pins are resumed by deferred multitimer callbacks, so they also run in
+    // the main loop and never inside an ISR.
+    class scheduler
+    {
+        static inline queue<std::coroutine_handle<>, GB7_TASK_COUNT> ready; // main loop only
+
+    public:
+        scheduler() = delete;
+
+        static bool spawn(task&& t) noexcept
+        {
+            if (!t.h || !ready.push(std::coroutine_handle<>(t.h))) return false;
+
+            t.h = {};
+            return true;
+        }
+
+        // tasks which could not be created because their frame exceeds GB7_TASK_FRAME_SIZE
+        static uint8_t oversized_frames() noexcept
+        {
+            return task::promise_type::oversized;
+        }
+
+        static bool schedule(std::coroutine_handle<> h) noexcept
+        {
+            return ready.push(static_cast<std::coroutine_handle<>&&>(h));
+        }
+
+        // Resumes everything that became ready since the last call.
+        static void run_once() noexcept
+        {
+            timer::multitimer::dispatch();
+
+            // tasks which yield now run again on the next call
+            for (size_t i = ready.size(); i > 0; i--)
+            {
+                std::coroutine_handle<> h;
+                ready.pop(h);
+                h.resume();
+            }
+        }
+
+        [[noreturn]] static void run() noexcept
+        {
+            timer::multitimer::init();
+            while (true)
+            {
+                run_once();
+                // sleep until an interrupt unless a yielding task is waiting
+                if (ready.empty()) power::idle();
+            }
+        }
+    };
+
+
+    /*
+     * awaitables
+     */
+
+    // co_await yield {}; lets the other ready tasks run first
+    struct yield
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        bool await_suspend(std::coroutine_handle<> h) const noexcept
+        {
+            // keep running if the ready queue is full
+            return scheduler::schedule(h);
+        }
+        void await_resume() const noexcept {}
+    };
+} // namespace gb7::coro
+
+#endif // TASK_HPP
@@ -3,12 +3,27 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "priority_queue.hpp"
+#include "ring_buffer.hpp"
+
+#ifdef GB7_TIMER_TRACE
+#include "trace.hpp"
+#endif // GB7_TIMER_TRACE
 
 #ifndef F_CPU
 #define F_CPU 8000000
 #endif // F_CPU
 
+// Timer1 has no useful fixed tick, so it is always driven by compare match.
+#if defined GB7_TIMER_USE_TIMER1 && !defined GB7_TIMER_TICKLESS
+#define GB7_TIMER_TICKLESS
+#endif // GB7_TIMER_USE_TIMER1
+
+#ifndef GB7_TIMER_READY_QUEUE_SIZE
+#define GB7_TIMER_READY_QUEUE_SIZE 8
+#endif // GB7_TIMER_READY_QUEUE_SIZE
+
 
 namespace gb7::timer
 {
@@ -30,6 +45,30 @@ namespace gb7::timer
             fast_pwm          = 0b11,
             phase_correct_pwm = 0b01,
         };
+        // WGM13:10 of Timer1
+        enum class timer1_mode
+        {
+            normal                           = 0b0000,
+            phase_correct_pwm_8bit           = 0b0001,
+            phase_correct_pwm_9bit           = 0b0010,
+            phase_correct_pwm_10bit          = 0b0011,
+            ctc_ocra                         = 0b0100,
+            fast_pwm_8bit                    = 0b0101,
+            fast_pwm_9bit                    = 0b0110,
+            fast_pwm_10bit                   = 0b0111,
+            phase_frequency_correct_pwm_icr  = 0b1000,
+            phase_frequency_correct_pwm_ocra = 0b1001,
+            phase_correct_pwm_icr            = 0b1010,
+            phase_correct_pwm_ocra           = 0b1011,
+            ctc_icr                          = 0b1100,
+            fast_pwm_icr                     = 0b1110,
+            fast_pwm_ocra                    = 0b1111,
+        };
+        enum class capture_edge
+        {
+            falling = 0b0,
+            rising  = 0b1,
+        };
         enum class timer_top
         {
             ff   = 0b0,
@@ -68,6 +107,19 @@ namespace gb7::timer
                 OCR0A = ocr0a;
             }
 
+            inline static uint8_t get_count() noexcept
+            {
+                return TCNT0;
+            }
+            inline static void set_count(uint8_t count) noexcept
+            {
+                TCNT0 = count;
+            }
+            inline static void set_compare_match_a(uint8_t count) noexcept
+            {
+                OCR0A = count;
+            }
+
             inline static void enable_compare_match_a_interrupt(uint8_t count) noexcept
             {
                 TIMSK0 |= 0b010;
@@ -84,6 +136,86 @@ namespace gb7::timer
             }
         };
 
+        // 16-bit registers share one TEMP register, so accesses which can race with
+        // an ISR touching Timer1 must be done with interrupts disabled.
+        class raw_timer1
+        {
+        public:
+            raw_timer1() = delete;
+
+            static void init(pwm_mode oc1a, pwm_mode oc1b, timer1_mode mode, clock_division division,
+                capture_edge edge = capture_edge::falling, bool noise_canceler = false) noexcept
+            {
+                TCCR1A =
+                    (static_cast<uint8_t>(oc1a) << 6) |
+                    (static_cast<uint8_t>(oc1b) << 4) |
+                    (static_cast<uint8_t>(mode) & 0b11);
+                TCCR1B =
+                    (static_cast<uint8_t>(noise_canceler) << 7) |
+                    (static_cast<uint8_t>(edge) << 6) |
+                    ((static_cast<uint8_t>(mode) >> 2) << 3) |
+                    (static_cast<uint8_t>(division));
+            }
+
+            inline static void set_ctc_top(uint16_t ocr1a) noexcept
+            {
+                OCR1A = ocr1a;
+            }
+            // TOP for the *_icr modes; ICR1 is not used for capture then
+            inline static void set_icr_top(uint16_t icr1) noexcept
+            {
+                ICR1 = icr1;
+            }
+
+            inline static uint16_t get_count() noexcept
+            {
+                return TCNT1;
+            }
+            inline static void set_count(uint16_t count) noexcept
+            {
+                TCNT1 = count;
+            }
+            inline static void set_compare_match_a(uint16_t count) noexcept
+            {
+                OCR1A = count;
+            }
+            inline static void set_compare_match_b(uint16_t count) noexcept
+            {
+                OCR1B = count;
+            }
+            inline static uint16_t get_input_capture() noexcept
+            {
+                return ICR1;
+            }
+            inline static void set_capture_edge(capture_edge edge) noexcept
+            {
+                TCCR1B = (TCCR1B & ~(1 << 6)) | (static_cast<uint8_t>(edge) << 6);
+            }
+
+            inline static void enable_compare_match_a_interrupt(uint16_t count) noexcept
+            {
+                TIMSK1 |= 0b000010;
+                OCR1A = count;
+            }
+            inline static void enable_compare_match_b_interrupt(uint16_t count) noexcept
+            {
+                TIMSK1 |= 0b000100;
+                OCR1B = count;
+            }
+            inline static void enable_overflow_interrupt() noexcept
+            {
+                TIMSK1 |= 0b000001;
+            }
+            inline static void enable_input_capture_interrupt() noexcept
+            {
+                TIMSK1 |= 0b100000;
+            }
+            inline static void disable_interrupts() noexcept
+            {
+                TIMSK1 = 0;
+            }
+        };
+
         class raw_timer2
         {
         public:
@@ -105,6 +237,19 @@ namespace gb7::timer
                 OCR2A = ocr2a;
             }
 
+            inline static uint8_t get_count() noexcept
+            {
+                return TCNT2;
+            }
+            inline static bool overflow_pending() noexcept
+            {
+                return TIFR2 & 0b001;
+            }
+            inline static void set_compare_match_a(uint8_t count) noexcept
+            {
+                OCR2A = count;
+            }
+
             inline static void enable_compare_match_a_interrupt(uint8_t count) noexcept
             {
                 TIMSK2 |= 0b010;
@@ -123,25 +268,159 @@ namespace gb7::timer
     } // namespace raw_timers
 
 
+    // CPU cycles per multitimer tick: one Timer1 count at /8, or one Timer2 overflow at /8
+#ifdef GB7_TIMER_USE_TIMER1
+    constexpr uint32_t tick_cycles = 8;
+#else
+    constexpr uint32_t tick_cycles = 8 * 256;
+#endif // GB7_TIMER_USE_TIMER1
+
+    // A count of Num/Den seconds. Conversions are integer-only, with the ratio
+    // between two units reduced at compile time.
+    template<uint32_t Num, uint32_t Den>
+    class duration
+    {
+        uint32_t v;
+
+    public:
+        static constexpr uint32_t num = Num;
+        static constexpr uint32_t den = Den;
+
+        constexpr explicit duration(uint32_t count) noexcept : v(count) {}
+
+        constexpr uint32_t count() const noexcept
+        {
+            return v;
+        }
+    };
+
+    // Longest delay or period multitimer accepts. Heap deadlines are compared
+    // wrap-safely, which needs them less than 2^31 ticks apart; the rest is
+    // headroom for the ticks elapsed since the last interrupt. That is about
+    // 35 minutes with Timer1 and 6 days with Timer2 at 8MHz.
+    constexpr time_unit max_ticks = 0x7fff0000;
+
+    using ticks        = duration<tick_cycles, F_CPU>;
+    using microseconds = duration<1, 1000000>;
+    using milliseconds = duration<1, 1000>;
+    using seconds      = duration<1, 1>;
+
+    namespace duration_detail
+    {
+        constexpr uint64_t gcd(uint64_t a, uint64_t b) noexcept
+        {
+            while (b != 0)
+            {
+                const uint64_t t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+
+        // Deliberately not constexpr, so an overflowing conversion in a constant
+        // expression fails the build; at run time the result saturates instead.
+        inline void duration_overflow() noexcept {}
+
+        // Multiplies by P/Q, rounding to nearest. Whole multiples of Q are scaled
+        // separately, so only a result above 32 bits overflows.
+        template<uint64_t P, uint64_t Q>
+        constexpr uint32_t scale(uint32_t v) noexcept
+        {
+            static_assert((Q - 1) * P + Q / 2 <= 0xffffffff, "duration ratio does not fit in 32 bits");
+
+            const uint32_t whole = v / Q;
+            const uint32_t low = (v % Q * static_cast<uint32_t>(P) + static_cast<uint32_t>(Q / 2)) / Q;
+            if (whole > 0xffffffff / P || whole * static_cast<uint32_t>(P) > 0xffffffff - low)
+            {
+                duration_overflow();
+                return 0xffffffff;
+            }
+            return whole * static_cast<uint32_t>(P) + low;
+        }
+    } // namespace duration_detail
+
+    template<class To, uint32_t Num, uint32_t Den>
+    constexpr To duration_cast(duration<Num, Den> d) noexcept
+    {
+        constexpr uint64_t p = static_cast<uint64_t>(Num) * To::den;
+        constexpr uint64_t q = static_cast<uint64_t>(Den) * To::num;
+        constexpr uint64_t g = duration_detail::gcd(p, q);
+        return To(duration_detail::scale<p / g, q / g>(d.count()));
+    }
+
+    // Saturates at max_ticks; in a constant expression a longer duration fails the build.
+    template<uint32_t Num, uint32_t Den>
+    constexpr time_unit to_ticks(duration<Num, Den> d) noexcept
+    {
+        const time_unit t = duration_cast<ticks>(d).count();
+        if (t > max_ticks)
+        {
+            duration_detail::duration_overflow();
+            return max_ticks;
+        }
+        return t;
+    }
+
     namespace literals
     {
-        constexpr inline static double TIME_COEFF = (1e-6 * F_CPU) / 256 / 8;
-        constexpr time_unit operator""_us(unsigned long long v) noexcept
+        // Tick counts, rounded to the nearest tick. The operators are consteval,
+        // so a value above max_ticks always fails the build.
+        consteval time_unit operator""_us(unsigned long long v) noexcept
         {
-            return static_cast<time_unit>(v * TIME_COEFF);
+            if (v > 0xffffffff) duration_detail::duration_overflow();
+            return to_ticks(microseconds(v));
         }
-        constexpr time_unit operator""_ms(unsigned long long v) noexcept
+        consteval time_unit operator""_ms(unsigned long long v) noexcept
         {
-            return static_cast<time_unit>(v * TIME_COEFF * 1e3);
+            if (v > 0xffffffff) duration_detail::duration_overflow();
+            return to_ticks(milliseconds(v));
         }
-        constexpr time_unit operator""_s(unsigned long long v) noexcept
+        consteval time_unit operator""_s(unsigned long long v) noexcept
         {
-            return static_cast<time_unit>(v * TIME_COEFF * 1e6);
+            if (v > 0xffffffff) duration_detail::duration_overflow();
+            return to_ticks(seconds(v));
         }
     } // namespace literals
 
 
     using callback_func = void(*)(void*);
+    using timer_handle = uint16_t; // 0 is never a valid handle
+    class multitimer;
+
+    enum class dispatch_mode: uint8_t
+    {
+        interrupt, // run inside the timer ISR
+        deferred,  // queued for multitimer::dispatch() in the main loop
+    };
+
+    // Intrusive delta-list entry. The owner keeps the node alive while it is
+    // scheduled, so multitimer itself needs no storage per timer.
+    class timer_node
+    {
+        friend class multitimer;
+
+        timer_node* next = nullptr;
+        time_unit delta = 0; // ticks after the previous node
+        time_unit period = 0;
+        callback_func func;
+        void* data;
+        dispatch_mode mode;
+        bool linked = false;
+
+    public:
+        constexpr timer_node(callback_func f, void* d = nullptr, dispatch_mode m = dispatch_mode::interrupt) noexcept
+            : func(f), data(d), mode(m) {}
+
+        timer_node(const timer_node&) = delete;
+        timer_node& operator=(const timer_node&) = delete;
+
+        bool scheduled() const noexcept
+        {
+            return linked;
+        }
+    };
+
     class multitimer
     {
         struct item
@@ -150,13 +429,267 @@ namespace gb7::timer
             time_unit period;
             callback_func func;
             void* data;
+            dispatch_mode mode;
 
-            constexpr bool operator>(const item& lhs) const noexcept { return time > lhs.time; }
-            constexpr bool operator<(const item& lhs) const noexcept { return time < lhs.time; }
+            // wrap-safe, since deadlines stay within max_ticks of now
+            constexpr bool operator>(const item& lhs) const noexcept { return static_cast<int32_t>(time - lhs.time) > 0; }
+            constexpr bool operator<(const item& lhs) const noexcept { return static_cast<int32_t>(time - lhs.time) < 0; }
+        };
+        struct ready_item
+        {
+            callback_func func;
+            void* data;
+#ifdef GB7_TIMER_TRACE
+            time_unit due;
+#endif // GB7_TIMER_TRACE
         };
         static inline priority_queue<item, 16> q;
+        static_assert(sizeof(timer_handle) == sizeof(decltype(q)::handle));
+        // filled by the ISR, drained by dispatch() without disabling interrupts
+        static inline ring_buffer<ready_item, GB7_TIMER_READY_QUEUE_SIZE> ready;
+        static inline uint16_t ready_overflows = 0;
+
+#if defined GB7_TIMER_USE_TIMER1
+        // One tick is one count at /8, i.e. 1us at 8MHz.
+        struct hw
+        {
+            using counter = uint16_t;
+            static constexpr counter counts_per_tick = 1;
+            // upper bound between two compare matches, with margin for a late ISR
+            static constexpr time_unit max_sleep_ticks = 0x7000;
+            static constexpr uint16_t cycles_per_count = 8;
+            // counts a late compare is set ahead: reading TCNT1, adding and
+            // writing OCR1A take more than one count
+            static constexpr counter rearm_margin = 4;
+
+            static counter count() noexcept { return raw_timers::raw_timer1::get_count(); }
+            static void set_compare(counter c) noexcept { raw_timers::raw_timer1::set_compare_match_a(c); }
+        };
+#elif defined GB7_TIMER_TICKLESS
+        // Timer2 runs at /1024 instead of /8, so one tick (256 counts at /8) is 2 counts.
+        struct hw
+        {
+            using counter = uint8_t;
+            static constexpr counter counts_per_tick = 2;
+            static constexpr time_unit max_sleep_ticks = 120;
+            static constexpr uint16_t cycles_per_count = 1024;
+            static constexpr counter rearm_margin = 1;
+
+            static counter count() noexcept { return raw_timers::raw_timer2::get_count(); }
+            static void set_compare(counter c) noexcept { raw_timers::raw_timer2::set_compare_match_a(c); }
+        };
+#else
+        // Timer2 overflows once per tick at /8.
+        struct hw
+        {
+            using counter = uint8_t;
+            static constexpr uint16_t cycles_per_count = 8;
+
+            static counter count() noexcept { return raw_timers::raw_timer2::get_count(); }
+        };
+#endif // GB7_TIMER_USE_TIMER1
+
+        static inline hw::counter isr_max_counts = 0;
+#ifdef GB7_TIMER_TRACE
+        using trace_type = trace_buffer<hw::counter, hw::cycles_per_count>;
+        static inline trace_type tracer;
+#endif // GB7_TIMER_TRACE
+        static inline timer_node* head = nullptr;
         static inline time_unit now = 0;
         static inline bool initialized = false;
+        static inline timer_handle firing = 0; // invocation whose callback is running
+
+#ifdef GB7_TIMER_TICKLESS
+        static inline hw::counter last_count = 0; // counter value at the end of tick `now - 1`
+
+        // ticks which have passed but have not been processed yet
+        static time_unit elapsed() noexcept
+        {
+            return static_cast<hw::counter>(hw::count() - last_count) / hw::counts_per_tick;
+        }
+
+        static time_unit ticks_to_next() noexcept
+        {
+            time_unit step = hw::max_sleep_ticks;
+            if (head != nullptr && head->delta < step) step = head->delta;
+            if (!q.empty() && q.top().time - now < step) step = q.top().time - now;
+            return step;
+        }
+
+        static void skip(time_unit ticks) noexcept
+        {
+            now += ticks;
+            if (head != nullptr) head->delta -= ticks;
+            last_count += ticks * hw::counts_per_tick;
+        }
+
+        static void advance(time_unit ticks) noexcept
+        {
+            while (ticks > 0)
+            {
+                time_unit idle = ticks_to_next();
+                if (idle >= ticks)
+                {
+                    skip(ticks);
+                    return;
+                }
+
+                skip(idle);
+                last_count += hw::counts_per_tick;
+                process_tick();
+                ticks -= idle + 1;
+            }
+        }
+
+        static void rearm() noexcept
+        {
+            hw::counter target = (ticks_to_next() + 1) * hw::counts_per_tick;
+            hw::set_compare(last_count + target);
+
+            // A compare the counter has already reached would only match after a
+            // full wrap, so while it is behind, move it rearm_margin counts ahead.
+            hw::counter passed;
+            while ((passed = hw::count() - last_count) >= target)
+            {
+                target = passed + hw::rearm_margin;
+                hw::set_compare(last_count + target);
+            }
+        }
+#else
+        static constexpr time_unit elapsed() noexcept
+        {
+            return 0;
+        }
+
+        static void rearm() noexcept {}
+#endif // GB7_TIMER_TICKLESS
+
+        static void link(timer_node& n, time_unit time) noexcept
+        {
+            timer_node** p = &head;
+            while (*p != nullptr && (*p)->delta <= time)
+            {
+                time -= (*p)->delta;
+                p = &(*p)->next;
+            }
+
+            n.delta = time;
+            n.next = *p;
+            if (n.next != nullptr) n.next->delta -= time;
+            *p = &n;
+            n.linked = true;
+        }
+
+        static void run(callback_func f, void* d, dispatch_mode mode) noexcept
+        {
+            if (mode == dispatch_mode::interrupt)
+            {
+#ifdef GB7_TIMER_TRACE
+                const hw::counter start = hw::count();
+                f(d);
+                tracer.record({
+                    trace_type::event_type::callback, start, static_cast<hw::counter>(hw::count() - start),
+                    static_cast<hw::counter>(start - tick_start()), now, f
+                });
+#else
+                f(d);
+#endif // GB7_TIMER_TRACE
+            }
+#ifdef GB7_TIMER_TRACE
+            else if (!ready.push({ f, d, now }))
+#else
+            else if (!ready.push({ f, d }))
+#endif // GB7_TIMER_TRACE
+            {
+                ready_overflows++;
+            }
+        }
+
+        static void record_isr_time(hw::counter start) noexcept
+        {
+            const hw::counter counts = hw::count() - start;
+            if (counts > isr_max_counts) isr_max_counts = counts;
+#ifdef GB7_TIMER_TRACE
+            tracer.record({ trace_type::event_type::isr, start, counts, 0, now, nullptr });
+#endif // GB7_TIMER_TRACE
+        }
+
+#ifdef GB7_TIMER_TRACE
+        // counter value at which the tick being processed began
+        static hw::counter tick_start() noexcept
+        {
+#ifdef GB7_TIMER_TICKLESS
+            return last_count;
+#else
+            return 0; // the overflow starts every tick at 0
+#endif // GB7_TIMER_TICKLESS
+        }
+#endif // GB7_TIMER_TRACE
+
+        static void process_tick() noexcept
+        {
+            // delta list: only the head is touched unless something is due
+            while (head != nullptr && head->delta == 0)
+            {
+                timer_node* n = head;
+                head = n->next;
+                n->linked = false;
+
+                run(n->func, n->data, n->mode);
+
+                // the callback may have rescheduled or cancelled its own node
+                if (!n->linked && n->period > 0)
+                    link(*n, n->period);
+            }
+            if (head != nullptr) head->delta--;
+
+            if (q.empty())
+            {
+                now++;
+                return;
+            }
+
+            while (!q.empty() && q.top().time == now)
+            {
+                item temp = q.top();
+                const timer_handle h = q.top_handle();
+                firing = h;
+                run(temp.func, temp.data, temp.mode);
+
+                // the callback rescheduled or cancelled its own invocation
+                if (firing != h) continue;
+                firing = 0;
+
+                // it may also have added one which is now on top
+                const bool on_top = q.top_handle() == h;
+                if (temp.period > 0)
+                {
+                    temp.time += temp.period;
+                    if (on_top) q.update_top(temp);
+                    else q.update(h, temp);
+                }
+                else
+                {
+                    if (on_top) q.pop();
+                    else q.erase(h);
+                }
+            }
+            now++;
+        }
+
+        static void unlink(timer_node& n) noexcept
+        {
+            for (timer_node** p = &head; *p != nullptr; p = &(*p)->next)
+            {
+                if (*p == &n)
+                {
+                    *p = n.next;
+                    if (n.next != nullptr) n.next->delta += n.delta;
+                    n.linked = false;
+                    return;
+                }
+            }
+        }
 
     public:
         multitimer() = delete;
@@ -165,65 +698,299 @@ namespace gb7::timer
         {
             if (!initialized)
             {
+#if defined GB7_TIMER_USE_TIMER1
+                raw_timers::raw_timer1::init(
+                    raw_timers::pwm_mode::none, raw_timers::pwm_mode::none, raw_timers::timer1_mode::normal,
+                    raw_timers::clock_division::division_8
+                );
+
+                last_count = raw_timers::raw_timer1::get_count();
+                raw_timers::raw_timer1::enable_compare_match_a_interrupt(last_count);
+                rearm();
+#elif defined GB7_TIMER_TICKLESS
+                raw_timers::raw_timer2::init(
+                    raw_timers::pwm_mode::none, raw_timers::pwm_mode::none, raw_timers::timer_mode::normal,
+                    raw_timers::timer_top::ff, raw_timers::clock_division::division_1024
+                );
+
+                last_count = raw_timers::raw_timer2::get_count();
+                raw_timers::raw_timer2::enable_compare_match_a_interrupt(last_count);
+                rearm();
+#else
                 raw_timers::raw_timer2::init(
                     raw_timers::pwm_mode::none, raw_timers::pwm_mode::none, raw_timers::timer_mode::normal,
                     raw_timers::timer_top::ff, raw_timers::clock_division::division_8
                 );
 
                 raw_timers::raw_timer2::enable_overflow_interrupt();
+#endif // GB7_TIMER_USE_TIMER1
                 sei();
 
                 initialized = true;
             }
         }
 
-        static int invoke_in(time_unit time, callback_func f, void* d = nullptr) noexcept
+        static timer_handle invoke_in(time_unit time, callback_func f, void* d = nullptr, dispatch_mode mode = dispatch_mode::interrupt) noexcept
         {
-            if (f) return q.push({ now + time, 0, f, d });
-            return 0;
+            return invoke_every(0, time, f, d, mode);
         }
 
-        static uint32_t invoke_every(time_unit period, time_unit time, callback_func f, void* d = nullptr) noexcept
+        // Runs `f` `time` ticks from now, then every `period` ticks if it is not 0.
+        // Both are clamped to max_ticks.
+        static timer_handle invoke_every(time_unit period, time_unit time, callback_func f, void* d = nullptr, dispatch_mode mode = dispatch_mode::interrupt) noexcept
         {
-            if (f) return q.push({ now + time, period, f, d });
-            return 0;
+            if (!f) return 0;
+            if (time > max_ticks) time = max_ticks;
+            if (period > max_ticks) period = max_ticks;
+
+            timer_handle h = 0;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                h = q.push({ now + elapsed() + time, period, f, d, mode });
+                rearm();
+            }
+            return h;
         }
 
-        static bool cancel_invocation(uint32_t id) noexcept
+        template<uint32_t N, uint32_t D>
+        static timer_handle invoke_in(duration<N, D> time, callback_func f, void* d = nullptr, dispatch_mode mode = dispatch_mode::interrupt) noexcept
         {
-            return q.erase(id);
+            return invoke_every(0, to_ticks(time), f, d, mode);
         }
 
-        static void on_timer_interrupt() noexcept
+        template<uint32_t N1, uint32_t D1, uint32_t N2, uint32_t D2>
+        static timer_handle invoke_every(duration<N1, D1> period, duration<N2, D2> time, callback_func f, void* d = nullptr, dispatch_mode mode = dispatch_mode::interrupt) noexcept
+        {
+            return invoke_every(to_ticks(period), to_ticks(time), f, d, mode);
+        }
+
+        // Moves a pending invocation to fire `time` ticks from now, then every `period`,
+        // both clamped to max_ticks. Stale handles (already fired or cancelled) are rejected.
+        static bool reschedule(timer_handle h, time_unit period, time_unit time) noexcept
         {
-            if (q.empty()) return;
-            
-            while (q.top().time == now && q.top().func != nullptr)
+            if (time > max_ticks) time = max_ticks;
+            if (period > max_ticks) period = max_ticks;
+
+            bool found = false;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
             {
-                item temp = q.top();
-                temp.func(temp.data);
-                if (temp.period > 0)
+                item temp;
+                if (q.get(h, temp))
                 {
-                    temp.time += temp.period;
-                    q.update_top(temp);
+                    temp.time = now + elapsed() + time;
+                    temp.period = period;
+                    found = q.update(h, temp);
+                    if (h == firing) firing = 0;
+                    rearm();
                 }
-                else
+            }
+            return found;
+        }
+
+        static bool cancel_invocation(timer_handle h) noexcept
+        {
+            bool erased = false;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                erased = q.erase(h);
+                if (erased && h == firing) firing = 0;
+            }
+            return erased;
+        }
+
+        static void schedule_in(timer_node& n, time_unit time) noexcept
+        {
+            schedule_every(n, 0, time);
+        }
+
+        static void schedule_every(timer_node& n, time_unit period, time_unit time) noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                if (n.linked) unlink(n);
+                n.period = period;
+                if (n.func) link(n, elapsed() + time);
+                rearm();
+            }
+        }
+
+        template<uint32_t N, uint32_t D>
+        static void schedule_in(timer_node& n, duration<N, D> time) noexcept
+        {
+            schedule_every(n, 0, to_ticks(time));
+        }
+
+        template<uint32_t N1, uint32_t D1, uint32_t N2, uint32_t D2>
+        static void schedule_every(timer_node& n, duration<N1, D1> period, duration<N2, D2> time) noexcept
+        {
+            schedule_every(n, to_ticks(period), to_ticks(time));
+        }
+
+        static bool cancel(timer_node& n) noexcept
+        {
+            bool was_linked = false;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                was_linked = n.linked;
+                if (was_linked) unlink(n);
+                n.period = 0;
+            }
+            return was_linked;
+        }
+
+        // Ticks until the next scheduled callback is due; 0 while deferred callbacks
+        // wait for dispatch(), and ~0 when nothing is scheduled.
+        // Call with interrupts disabled.
+        static time_unit ticks_until_next() noexcept
+        {
+            if (!ready.empty()) return 0;
+
+            time_unit next = ~static_cast<time_unit>(0);
+            if (head != nullptr) next = head->delta;
+            if (!q.empty() && q.top().time - now < next) next = q.top().time - now;
+
+            const time_unit e = elapsed();
+            return next > e ? next - e : 0;
+        }
+
+        // Free-running timer counts since init(); wraps. One count is
+        // cycles_per_count CPU cycles. Call with interrupts disabled.
+        static uint32_t timestamp() noexcept
+        {
+#ifdef GB7_TIMER_TICKLESS
+            return now * hw::counts_per_tick + static_cast<hw::counter>(hw::count() - last_count);
+#else
+            uint8_t count = hw::count();
+            time_unit ticks = now;
+            // an overflow which the ISR has not handled yet
+            if (raw_timers::raw_timer2::overflow_pending())
+            {
+                count = hw::count();
+                ticks++;
+            }
+            return (ticks << 8) | count;
+#endif // GB7_TIMER_TICKLESS
+        }
+
+        static constexpr uint16_t cycles_per_count = hw::cycles_per_count;
+
+        // Runs deferred callbacks queued by the ISR; call it from the main loop.
+        // Returns the number of callbacks run.
+        static uint8_t dispatch() noexcept
+        {
+            uint8_t count = 0;
+            while (true)
+            {
+                ready_item temp;
+                if (!ready.pop(temp)) break;
+
+#ifdef GB7_TIMER_TRACE
+                // measured with interrupts enabled, so ISRs in between are included
+                hw::counter start;
+                time_unit tick;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
                 {
-                    q.pop();
+                    start = hw::count();
+                    tick = now;
                 }
+                temp.func(temp.data);
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    const time_unit late = tick - temp.due;
+                    tracer.record({
+                        trace_type::event_type::deferred, start, static_cast<hw::counter>(hw::count() - start),
+                        static_cast<hw::counter>(late > static_cast<hw::counter>(~0) ? static_cast<hw::counter>(~0) : late), tick, temp.func
+                    });
+                }
+#else
+                temp.func(temp.data);
+#endif // GB7_TIMER_TRACE
+                count++;
             }
-            now++;
+            return count;
         }
+
+        // deferred callbacks dropped because the ready queue was full
+        static uint16_t dropped_callbacks() noexcept
+        {
+            uint16_t v;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                v = ready_overflows;
+            }
+            return v;
+        }
+
+        // Upper bound of the longest timer ISR seen so far, in CPU cycles. The
+        // ISR is timed with the multitimer's own counter, so the bound is one
+        // count coarse: 8 cycles in tick and Timer1 modes, but 1024 in tickless
+        // mode, where a 300-cycle ISR reads as 1024 or 2048. Measure ISR costs
+        // in tick or Timer1 mode, or with the simavr benches (make bench).
+        static uint32_t isr_max_cycles() noexcept
+        {
+            hw::counter v;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                v = isr_max_counts;
+            }
+            return (static_cast<uint32_t>(v) + 1) * hw::cycles_per_count;
+        }
+
+        static void reset_isr_stats() noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                isr_max_counts = 0;
+                ready_overflows = 0;
+            }
+        }
+
+#ifdef GB7_TIMER_TRACE
+        // ISR and callback timings; see trace_buffer for dump() and stats()
+        static trace_type& trace() noexcept
+        {
+            return tracer;
+        }
+#endif // GB7_TIMER_TRACE
+
+        static void on_timer_interrupt() noexcept
+        {
+            const hw::counter start = hw::count();
+            process_tick();
+            record_isr_time(start);
+        }
+
+#ifdef GB7_TIMER_TICKLESS
+        static void on_compare_match() noexcept
+        {
+            const hw::counter start = hw::count();
+            advance(elapsed());
+            rearm();
+            record_isr_time(start);
+        }
+#endif // GB7_TIMER_TICKLESS
     };
 } // namespace gb7::timer
 
 
 #ifdef GB7_TIMER_USE_INVOKE
 
+#if defined GB7_TIMER_USE_TIMER1
+ISR(TIMER1_COMPA_vect)
+{
+    gb7::timer::multitimer::on_compare_match();
+}
+#elif defined GB7_TIMER_TICKLESS
+ISR(TIMER2_COMPA_vect)
+{
+    gb7::timer::multitimer::on_compare_match();
+}
+#else
 ISR(TIMER2_OVF_vect)
 {
     gb7::timer::multitimer::on_timer_interrupt();
 }
+#endif // GB7_TIMER_USE_TIMER1
 
 #else
 
@@ -0,0 +1,226 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <util/atomic.h>
+
+#ifndef GB7_TIMER_TRACE_SIZE
+#define GB7_TIMER_TRACE_SIZE 16
+#endif // GB7_TIMER_TRACE_SIZE
+
+
+namespace gb7::timer
+{
+    // Ring buffer of timer ISR and callback events plus running statistics.
+    // multitimer owns one when GB7_TIMER_TRACE is defined; all times are in
+    // counts of the timer driving multitimer.
+    template<class Counter, uint16_t CyclesPerCount, size_t N = GB7_TIMER_TRACE_SIZE>
+    class trace_buffer
+    {
+        static_assert(N > 0 && N < 256 && (N & (N - 1)) == 0, "trace size must be a power of two below 256");
+
+    public:
+        enum class event_type: uint8_t
+        {
+            isr,      // duration of one timer interrupt
+            callback, // callback run inside the ISR
+            deferred, // callback run by multitimer::dispatch()
+        };
+
+        struct event
+        {
+            event_type type;
+            Counter start;    // counter value when the event began
+            Counter duration;
+            Counter lateness; // counts after the deadline (ticks for deferred callbacks)
+            uint32_t tick;    // multitimer tick when the event was recorded
+            void (*func)(void*);
+        };
+
+        struct running
+        {
+            Counter max = 0;
+            void (*max_func)(void*) = nullptr;
+            uint32_t total = 0;
+            uint16_t count = 0;
+
+            void add(Counter v, void (*f)(void*)) noexcept
+            {
+                if (v >= max)
+                {
+                    max = v;
+                    max_func = f;
+                }
+                // halve both when full so the average keeps following recent events
+                if (count == 0xffff)
+                {
+                    total /= 2;
+                    count /= 2;
+                }
+                total += v;
+                count++;
+            }
+
+            Counter average() const noexcept
+            {
+                return count == 0 ? 0 : static_cast<Counter>(total / count);
+            }
+        };
+
+        struct summary
+        {
+            running isr;
+            running duration; // callbacks, both dispatch modes
+            running lateness; // callbacks run inside the ISR
+        };
+
+    private:
+        event events[N];
+        uint8_t next = 0;
+        uint8_t m_size = 0;
+        summary m_summary;
+
+        template<class Writer>
+        static void write(Writer& put, const char* s) noexcept
+        {
+            while (*s) put(*s++);
+        }
+
+        template<class Writer>
+        static void write(Writer& put, uint32_t v) noexcept
+        {
+            char buf[10];
+            uint8_t i = 0;
+            do
+            {
+                buf[i++] = '0' + v % 10;
+                v /= 10;
+            } while (v != 0);
+
+            while (i > 0) put(buf[--i]);
+        }
+
+        template<class Writer>
+        static void write_running(Writer& put, const char* name, const running& r, uint16_t scale) noexcept
+        {
+            write(put, name);
+            write(put, " max=");
+            write(put, static_cast<uint32_t>(r.max) * scale);
+            write(put, " avg=");
+            write(put, static_cast<uint32_t>(r.average()) * scale);
+            write(put, " n=");
+            write(put, r.count);
+            if (r.max_func != nullptr)
+            {
+                write(put, " worst=0x");
+                const uintptr_t p = reinterpret_cast<uintptr_t>(r.max_func);
+                for (int8_t shift = sizeof(p) * 8 - 4; shift >= 0; shift -= 4)
+                    put("0123456789abcdef"[(p >> shift) & 0xf]);
+            }
+            put('\n');
+        }
+
+    public:
+        static constexpr uint16_t cycles_per_count = CyclesPerCount;
+
+        // call with interrupts disabled (i.e. from the ISR)
+        void record(const event& e) noexcept
+        {
+            events[next] = e;
+            next = (next + 1) & (N - 1);
+            if (m_size < N) m_size++;
+
+            switch (e.type)
+            {
+            case event_type::isr:
+                m_summary.isr.add(e.duration, nullptr);
+                break;
+            case event_type::callback:
+                m_summary.duration.add(e.duration, e.func);
+                m_summary.lateness.add(e.lateness, e.func);
+                break;
+            case event_type::deferred:
+                m_summary.duration.add(e.duration, e.func);
+                break;
+            }
+        }
+
+        summary stats() const noexcept
+        {
+            summary temp;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                temp = m_summary;
+            }
+            return temp;
+        }
+
+        void clear() noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                next = 0;
+                m_size = 0;
+                m_summary = summary {};
+            }
+        }
+
+        // Calls func(const event&) for each stored event, oldest first.
+        template<class Func>
+        void each_of(Func func) const noexcept
+        {
+            uint8_t size, first;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                size = m_size;
+                first = (next - m_size) & (N - 1);
+            }
+
+            for (uint8_t i = 0; i < size; i++)
+            {
+                event temp;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    temp = events[(first + i) & (N - 1)];
+                }
+                func(temp);
+            }
+        }
+
+        // Writes the statistics and the stored events as text through put(char).
+        // Durations are in CPU cycles.
+        template<class Writer>
+        void dump(Writer put) const noexcept
+        {
+            const summary s = stats();
+            write_running(put, "isr", s.isr, CyclesPerCount);
+            write_running(put, "callback", s.duration, CyclesPerCount);
+            write_running(put, "lateness", s.lateness, CyclesPerCount);
+
+            each_of([&put](const event& e) {
+                static const char* const names[] = { "isr", "callback", "deferred" };
+                write(put, names[static_cast<uint8_t>(e.type)]);
+                write(put, " tick=");
+                write(put, e.tick);
+                write(put, " start=");
+                write(put, e.start);
+                write(put, " cycles=");
+                write(put, static_cast<uint32_t>(e.duration) * CyclesPerCount);
+                if (e.type == event_type::callback)
+                {
+                    write(put, " late=");
+                    write(put, static_cast<uint32_t>(e.lateness) * CyclesPerCount);
+                }
+                else if (e.type == event_type::deferred)
+                {
+                    write(put, " late_ticks=");
+                    write(put, e.lateness);
+                }
+                put('\n');
+            });
+        }
+    };
+} // namespace gb7::timer
+
+#endif // TRACE_HPP
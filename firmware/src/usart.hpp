@@ -0,0 +1,276 @@
+#ifndef USART_HPP
+#define USART_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "ring_buffer.hpp"
+
+#ifndef GB7_USART_BAUD
+#define GB7_USART_BAUD 38400
+#endif // GB7_USART_BAUD
+
+// Largest accepted baud rate error, in tenths of a percent.
+#ifndef GB7_USART_MAX_ERROR
+#define GB7_USART_MAX_ERROR 20
+#endif // GB7_USART_MAX_ERROR
+
+// Buffer sizes in bytes; powers of two up to 128.
+#ifndef GB7_USART_TX_SIZE
+#define GB7_USART_TX_SIZE 64
+#endif // GB7_USART_TX_SIZE
+
+#ifndef GB7_USART_RX_SIZE
+#define GB7_USART_RX_SIZE 32
+#endif // GB7_USART_RX_SIZE
+
+
+namespace gb7
+{
+    namespace usart_detail
+    {
+        struct baud_setting
+        {
+            uint16_t ubrr;
+            bool double_speed;
+            uint32_t error; // tenths of a percent
+        };
+
+        constexpr baud_setting setting_with(uint32_t baud, uint8_t divisor, bool double_speed) noexcept
+        {
+            // rounded; UBRR0 has 12 bits
+            uint32_t ubrr = (F_CPU + divisor * baud / 2) / (divisor * baud);
+            ubrr = ubrr == 0 ? 0 : ubrr - 1;
+            if (ubrr > 4095) ubrr = 4095;
+
+            const uint32_t actual = F_CPU / (divisor * (ubrr + 1));
+            const uint32_t diff = actual > baud ? actual - baud : baud - actual;
+            return { static_cast<uint16_t>(ubrr), double_speed, static_cast<uint32_t>(diff * 1000ull / baud) };
+        }
+
+        // Normal speed samples each bit more often, so it wins a tie.
+        constexpr baud_setting setting_for(uint32_t baud) noexcept
+        {
+            const baud_setting normal = setting_with(baud, 16, false);
+            const baud_setting fast = setting_with(baud, 8, true);
+            return fast.error < normal.error ? fast : normal;
+        }
+    } // namespace usart_detail
+
+    // USART0 at GB7_USART_BAUD, 8N1, fed by interrupts. write() and read()
+    // only copy to and from ring buffers and never wait, so logging cannot
+    // stall the main loop; bytes that do not fit are counted and dropped.
+    // UBRR0 is chosen at compile time from F_CPU, and the build fails if the
+    // baud rate is off by more than GB7_USART_MAX_ERROR. Power-save stops the
+    // USART clock, so power::idle() only idles while the receiver is on or a
+    // byte is still queued or shifting out.
+    //   usart::init();
+    //   usart::print("score ");
+    //   uint8_t buf[8];
+    //   const size_t n = usart::read(buf);
+    class usart
+    {
+    public:
+        static constexpr usart_detail::baud_setting setting = usart_detail::setting_for(GB7_USART_BAUD);
+        static_assert(setting.error <= GB7_USART_MAX_ERROR, "GB7_USART_BAUD cannot be generated from F_CPU within GB7_USART_MAX_ERROR");
+
+    private:
+        static inline ring_buffer<uint8_t, GB7_USART_TX_SIZE> tx; // pushed by the main loop, popped in the UDRE ISR
+        static inline ring_buffer<uint8_t, GB7_USART_RX_SIZE> rx; // pushed in the RX ISR, popped by the main loop
+        static inline uint16_t rx_overflow_count = 0;
+        static inline uint16_t rx_error_count = 0;
+        static inline uint16_t tx_dropped_count = 0; // main loop only
+        static inline volatile bool sent = false;    // a byte went out since the last flush()
+
+        // The UDRE ISR clears UDRIE0 when the buffer runs empty. If it does so
+        // between the load and store here, the bit is set again and the ISR
+        // just runs once more and finds nothing to send.
+        static void start_transmit() noexcept
+        {
+            UCSR0B |= _BV(UDRIE0);
+        }
+
+        static uint16_t read_counter(const uint16_t& c) noexcept
+        {
+            uint16_t v;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                v = c;
+            }
+            return v;
+        }
+
+    public:
+        usart() = delete;
+
+        static void init() noexcept
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                UBRR0 = setting.ubrr;
+                UCSR0A = setting.double_speed ? _BV(U2X0) : 0;
+                UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+                UCSR0B = _BV(RXCIE0) | _BV(RXEN0) | _BV(TXEN0);
+            }
+            sei();
+        }
+
+        /*
+         * transmit, main loop only
+         */
+        static bool write(uint8_t c) noexcept
+        {
+            if (!tx.push(c))
+            {
+                tx_dropped_count++;
+                return false;
+            }
+            start_transmit();
+            return true;
+        }
+
+        // Queues as many bytes as fit; returns how many were queued.
+        static size_t write(const uint8_t* data, size_t count) noexcept
+        {
+            const size_t n = tx.push(data, count);
+            tx_dropped_count += count - n;
+            if (n > 0) start_transmit();
+            return n;
+        }
+
+        template<size_t N>
+        static size_t write(const uint8_t (&data)[N]) noexcept
+        {
+            return write(data, N);
+        }
+
+        // a NUL-terminated string, without the NUL
+        static size_t print(const char* s) noexcept
+        {
+            size_t n = 0;
+            while (s[n] != '\0') n++;
+            return write(reinterpret_cast<const uint8_t*>(s), n);
+        }
+
+        // free space in the transmit buffer
+        static size_t writable() noexcept
+        {
+            return tx.capacity() - tx.size();
+        }
+
+        // Waits until every queued byte has left the shift register, e.g.
+        // before sleeping or resetting. Needs interrupts enabled.
+        static void flush() noexcept
+        {
+            while (UCSR0B & _BV(UDRIE0));
+            if (!sent) return;
+
+            while (!(UCSR0A & _BV(TXC0)));
+            sent = false;
+        }
+
+        /*
+         * receive, main loop only
+         */
+        static bool read(uint8_t& c) noexcept
+        {
+            return rx.pop(c);
+        }
+
+        // Takes up to `count` received bytes; returns how many were taken.
+        static size_t read(uint8_t* data, size_t count) noexcept
+        {
+            return rx.pop(data, count);
+        }
+
+        template<size_t N>
+        static size_t read(uint8_t (&data)[N]) noexcept
+        {
+            return read(data, N);
+        }
+
+        static size_t available() noexcept
+        {
+            return rx.size();
+        }
+
+        /*
+         * counters since init()
+         */
+
+        // received bytes lost to a full buffer or a hardware data overrun
+        static uint16_t rx_overflows() noexcept
+        {
+            return read_counter(rx_overflow_count);
+        }
+
+        // received bytes dropped for a framing or parity error
+        static uint16_t rx_errors() noexcept
+        {
+            return read_counter(rx_error_count);
+        }
+
+        // bytes write() could not queue
+        static uint16_t tx_dropped() noexcept
+        {
+            return tx_dropped_count;
+        }
+
+        /*
+         * interrupt handlers
+         */
+        static void on_receive() noexcept
+        {
+            // the flags belong to the byte in UDR0, so read them first
+            const uint8_t status = UCSR0A;
+            const uint8_t c = UDR0;
+
+            if (status & _BV(DOR0)) rx_overflow_count++;
+            if (status & (_BV(FE0) | _BV(UPE0)))
+            {
+                rx_error_count++;
+                return;
+            }
+            if (!rx.push(c)) rx_overflow_count++;
+        }
+
+        static void on_data_register_empty() noexcept
+        {
+            uint8_t c;
+            if (!tx.pop(c))
+            {
+                UCSR0B &= static_cast<uint8_t>(~_BV(UDRIE0));
+                return;
+            }
+
+            // clear TXC0 (by writing one) for flush(), keeping U2X0
+            UCSR0A = (UCSR0A & _BV(U2X0)) | _BV(TXC0);
+            UDR0 = c;
+            sent = true;
+        }
+    };
+} // namespace gb7
+
+
+#ifdef GB7_USART_USE_ISR
+
+ISR(USART_RX_vect)
+{
+    gb7::usart::on_receive();
+}
+
+ISR(USART_UDRE_vect)
+{
+    gb7::usart::on_data_register_empty();
+}
+
+#else
+
+#warning "GB7_USART_USE_ISR must be defined elsewhere."
+
+#endif // GB7_USART_USE_ISR
+
+#endif // USART_HPP
@@ -3,6 +3,10 @@
 
 #include "utils.hpp"
 
+#ifdef GB7_USE_POOL_ALLOCATOR
+#include "pool_allocator.hpp"
+#endif // GB7_USE_POOL_ALLOCATOR
+
 
 int __cxa_guard_acquire(__guard* g)
 {
@@ -16,11 +20,33 @@ void __cxa_guard_abort(__guard*g ) {}
 void __cxa_pure_virtual() {}
 
 
+#ifdef GB7_USE_POOL_ALLOCATOR
+
+void* operator new(size_t size)
+{
+    return gb7::pool_allocator::allocate(size);
+}
+void operator delete(void* ptr, size_t size) noexcept
+{
+    gb7::pool_allocator::deallocate(ptr);
+}
+
+void* operator new[](size_t size)
+{
+    return gb7::pool_allocator::allocate(size);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+    gb7::pool_allocator::deallocate(ptr);
+}
+
+#else
+
 void* operator new(size_t size)
 {
     return malloc(size);
 }
-void operator delete(void* ptr, size_t size)
+void operator delete(void* ptr, size_t size) noexcept
 {
     free(ptr);
 }
@@ -29,11 +55,13 @@ void* operator new[](size_t size)
 {
     return malloc(size);
 }
-void operator delete[](void* ptr, size_t)
+void operator delete[](void* ptr, size_t) noexcept
 {
     free(ptr);
 }
 
+#endif // GB7_USE_POOL_ALLOCATOR
+
 void delay_ms(int miliseconds) noexcept
 {
     for (int i = 0; i < miliseconds; i++)
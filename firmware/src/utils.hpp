@@ -16,10 +16,10 @@ extern "C"
 
 
 void* operator new(size_t size);
-void operator delete(void* ptr, size_t size);
+void operator delete(void* ptr, size_t size) noexcept;
 
 void* operator new[](size_t size);
-void operator delete[](void* ptr, size_t size);
+void operator delete[](void* ptr, size_t size) noexcept;
 
 
 template<class T>
@@ -37,6 +37,15 @@ inline T max(T a, T b)
 template<class T>
 struct remove_reference { typedef T type; };
 
+template<bool B, class T, class F>
+struct conditional { typedef T type; };
+template<class T, class F>
+struct conditional<false, T, F> { typedef F type; };
+
+// smallest unsigned type holding every index and the size of an N-element container
+template<size_t N>
+using index_type = typename conditional<(N <= 0xff), uint8_t, uint16_t>::type;
+
 template<class T>
 constexpr typename remove_reference<T>::type&& move(T&& t) noexcept
 {
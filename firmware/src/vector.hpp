@@ -9,8 +9,10 @@ namespace gb7
     template<class T, size_t N = 16>
     class vector
     {
+        using index = index_type<N>;
+
         T arr[N];
-        size_t top = 0;
+        index top = 0;
 
     public:
         bool push(const T& v) noexcept
@@ -44,7 +46,7 @@ namespace gb7
         template<class Function>
         size_t find(Function comparator) const noexcept
         {
-            for (size_t i=0, s=size(); i < s; i++)
+            for (index i=0, s=top; i < s; i++)
             {
                 if (comparator(arr[i]))
                 {
@@ -91,7 +91,8 @@ document.addEventListener('load', e => {
         try
         {
             const notes = convertToNotes(textarea.value);
-            result.value = notes.map(note => 'speaker::enqueue_note(Tone::' + note.tone + ', ' + note.length + 'e6);\n').join('');
+            // compiled into a PROGMEM table by the _song literal in firmware/src/song.hpp
+            result.value = 'R"(\n' + notes.map(note => note.tone + ': ' + note.length + '\n').join('') + ')"_song';
             result.focus();
             result.select();
         }